@@ -0,0 +1,35 @@
+#version 460 core
+
+in vec3 gTexCoord;
+in vec3 gFaceNormal;
+in float gAO;
+in vec2 gLight;
+
+out vec4 FragColor;
+uniform sampler2DArray atlasTexture;
+// cutout faces drop fragments below, translucent faces pass 0 and are blended
+uniform float alphaCutoff;
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 lightDir; // xyz, towards the sun
+    vec4 cameraPos;
+};
+
+void main() {
+    // FragColor = vec4(gTexCoord.x, gTexCoord.y, 0.0, 1.0);
+    // FragColor = mix(texture(atlasTexture, gTexCoord), vec4(gTexCoord.x, gTexCoord.y, 0.0, 1.0), 0.1);
+    // FragColor = texture(atlasTexture, gTexCoord);
+
+    float ambientStrength = 0.5;
+
+    // sun only reaches blocks with skylight, block light is not directional
+    vec3 diff = vec3(max(dot(gFaceNormal, lightDir.xyz), 0.0f)+ambientStrength) * gLight.x;
+    vec3 light = max(diff, vec3(gLight.y));
+    vec4 texColor = texture(atlasTexture, gTexCoord);
+    if (texColor.a < alphaCutoff) discard;
+
+    vec3 resultColor = light * gAO * texColor.rgb;
+    FragColor = vec4(resultColor, texColor.a);
+}
\ No newline at end of file
@@ -5,9 +5,13 @@ layout(triangle_strip, max_vertices = 3) out;
 
 in vec3 vWorldPos[];
 in vec3 TexCoord[];
+in float vAO[];
+in vec2 vLight[];
 
 out vec3 gFaceNormal;
 out vec3 gTexCoord;
+out float gAO;
+out vec2 gLight;
 
 void main() {
     vec3 edge1 = vWorldPos[1] - vWorldPos[0];
@@ -18,6 +22,8 @@ void main() {
     for (int i=0; i<3; i++) {
         gl_Position = gl_in[i].gl_Position;
         gTexCoord = TexCoord[i];
+        gAO = vAO[i];
+        gLight = vLight[i];
         EmitVertex();
     }
     EndPrimitive();
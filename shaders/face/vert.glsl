@@ -1,27 +1,47 @@
 #version 440 core
-layout(location = 0) in int aPos;
-layout(location = 1) in int aPos1;
+// 64 bit vertex word as low and high half
+layout(location = 0) in ivec2 aVertex;
 
-uniform mat4 view;
-uniform mat4 projection;
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 lightDir; // xyz, towards the sun
+    vec4 cameraPos;
+};
 uniform ivec3 chunkCoords; // Chunk position in world (e.g., chunkCoords * 16 gives world offset)
+uniform float lodScale; // Size of one mesh cell in blocks (1 << LOD)
 const int CHUNK_SIZE = 32; // Adjust if your chunk size differs
 
 layout(location=0) out vec3 TexCoord;
 layout(location=1) out vec3 vWorldPos;
+layout(location=2) out float vAO;
+layout(location=3) out vec2 vLight; // sky, block
+
+// Light left by 0..3 occluding blocks around the vertex
+const float AO_CURVE[4] = float[4](1.0, 0.75, 0.55, 0.4);
 
 void main() {
+    int aPos = aVertex.x;
+    int aPos1 = aVertex.y;
+
     // Extract local position within the chunk (6 bits each)
     int x = (aPos & 0x3F);
     int y = (aPos >> 6) & 0x3F;
     int z = (aPos >> 12) & 0x3F;
 
     // Calculate world position by adding chunk offset
-    vWorldPos = vec3(x, y, z) + vec3(chunkCoords * CHUNK_SIZE);
+    vWorldPos = vec3(x, y, z) * lodScale + vec3(chunkCoords * CHUNK_SIZE);
+
+    // Texture coordinates (from bits 12 and 13), repeated once per block on LOD meshes
+    TexCoord = vec3(((aPos >> 18) & 0x3F) * lodScale, ((aPos >> 24) & 0x3F) * lodScale, ((aPos >> 30) & 0x3) | ((aPos1 & 0x1FF) << 2));
+
+    // Ambient occlusion (2 bits above the layer)
+    vAO = AO_CURVE[(aPos1 >> 9) & 0x3];
 
-    // Texture coordinates (from bits 12 and 13)
-    TexCoord = vec3((aPos >> 18) & 0x3F, (aPos >> 24) & 0x3F, (aPos>>30)&0x7FF);
+    // Sky and block light levels 0..15 (above AO), every level is 20% darker
+    vLight = pow(vec2(0.8), 15.0 - vec2((aPos1 >> 15) & 0xF, (aPos1 >> 11) & 0xF));
 
     // Transform to clip space
-    gl_Position = projection * view * vec4(vWorldPos, 1.0);
+    gl_Position = viewProjection * vec4(vWorldPos, 1.0);
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #version 330 core
 in vec2 vTexCoord;
+in vec4 vColor;
 out vec4 FragColor;
 
 uniform sampler2D uAtlas;
@@ -11,7 +12,8 @@ void main() {
     // Discard transparent pixels
     if(texColor.a < 0.1) discard;
 
+    texColor *= vColor;
     texColor.a *= uOpacity;
 
     FragColor = texColor;
-}
\ No newline at end of file
+}
@@ -4,28 +4,47 @@ layout(location = 1) in vec3 aInstanceData; // xyz=world pos
 layout(location = 2) in float scale;
 layout(location = 3) in float size;
 layout(location = 4) in vec2 uv; // uv start
+layout(location = 5) in vec4 color;
+layout(location = 6) in vec4 motion; // xyz velocity, w loop period in seconds
+layout(location = 7) in vec3 anim; // phase, growth, twinkle
 
-uniform mat4 uMVP;
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 lightDir; // xyz, towards the sun
+    vec4 cameraPos;
+};
 uniform mat4 uSkyRotation;  // Rotation matrix for day/night cycle
-uniform vec3 uCameraRight;
-uniform vec3 uCameraUp;
-uniform vec3 uCameraPos;
+uniform float uTime; // seconds
 
 out vec2 vTexCoord;
+out vec4 vColor;
+
+const float TWINKLE_SPEED = 3.0;
 
 void main() {
+    float time = uTime + anim.x;
+
+    // looping quads move along velocity and grow, fading in and out at the ends of the loop
+    float age = motion.w > 0.0 ? mod(time, motion.w) / motion.w : 0.0;
+    float fade = motion.w > 0.0 ? smoothstep(0.0, 0.1, age) * (1.0 - age) : 1.0;
+    vec3 center = aInstanceData + motion.xyz * age * motion.w;
+    float quadScale = scale + anim.y * age;
 
-    // Rotate the star position around world origin
-    vec3 rotatedPos = (uSkyRotation * vec4(aInstanceData, 1.0)).xyz;
+    float brightness = 1.0 - anim.z * (0.5 + 0.5 * sin(time * TWINKLE_SPEED));
+    vColor = vec4(color.rgb * brightness, color.a * fade);
 
-    // Place star at rotated position
-    vec3 worldCenter = rotatedPos;
+    // Rotate around world origin, sky stays centered on camera
+    vec3 worldCenter = (uSkyRotation * vec4(center, 1.0)).xyz;
 
-    // Billboard expansion
+    // Billboard expansion, camera right and up are rows of the view matrix
+    vec3 cameraRight = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 cameraUp = vec3(view[0][1], view[1][1], view[2][1]);
     vec3 posWorld = worldCenter
-            + uCameraRight * aPos.x * scale
-            + uCameraUp * aPos.y * scale;
+            + cameraRight * aPos.x * quadScale
+            + cameraUp * aPos.y * quadScale;
 
     vTexCoord = uv + (aPos.xy * 0.5 + 0.5) * size;
-    gl_Position = uMVP * vec4(posWorld, 1.0);
-}
\ No newline at end of file
+    gl_Position = projection * mat4(mat3(view)) * vec4(posWorld, 1.0);
+}
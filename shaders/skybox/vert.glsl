@@ -2,12 +2,17 @@
 layout(location = 0) in vec3 aPos;
 out vec3 vTexCoords;
 
-uniform mat4 uView;
-uniform mat4 uProjection;
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 lightDir; // xyz, towards the sun
+    vec4 cameraPos;
+};
 
 void main()
 {
     vTexCoords = aPos;
-    vec4 pos = uProjection * mat4(mat3(uView)) * vec4(aPos, 1.0);
+    vec4 pos = projection * mat4(mat3(view)) * vec4(aPos, 1.0);
     gl_Position = pos;
 }
\ No newline at end of file
@@ -1,11 +1,18 @@
 #include "Application.h"
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <thread>
 #include <fstream>
 
+#include "game/data_loaders/AssetBundle.h"
+#include "game/data_loaders/BlockLoader.h"
 #include "game/data_loaders/globals.h"
+#include "game/world/BlockRegistry.hpp"
 
 #include "render/globals.h"
+#include "utils/JobSystem.hpp"
 
 Application::Application(): camera(float(render::screenWidth) / float(render::screenHeight)) {
     Init();
@@ -43,6 +50,8 @@ void Application::Run() {
 
         // Rest of the loop (HandleEvents, Update, Render)
         if (!HandleEvents()) break;
+        // jobs needing the GL context
+        jobSystem.runMainThreadJobs();
         Update(deltaTime / 1000.0f); // Convert ms to seconds
 
         glBeginQuery(GL_TIME_ELAPSED, queryID);
@@ -61,6 +70,24 @@ void Application::Run() {
             for (auto frameTime : frametimes) sum += frameTime;
             std::cout << "Avg FPS: " << 1000.0 * frame_avg_count / sum << "; Min: " <<
                 1000.0f / *std::ranges::max_element(frametimes) << std::endl;
+            const auto& stats = worldRenderer.getResidency().getStats();
+            std::cout << "Chunks evicted: " << stats.evicted << "; Regenerations avoided: " <<
+                stats.regenerationsAvoided << "; Remeshes avoided: " << stats.remeshesAvoided << std::endl;
+            auto& occlusion = worldRenderer.getOcclusionCuller();
+            const auto& culled = occlusion.getStats();
+            std::cout << "Sub chunks occluded: " <<
+                (culled.tested ? 100.0 * culled.culled / culled.tested : 0.0) << "% of " <<
+                culled.tested / frame_avg_count << " per frame" << std::endl;
+            occlusion.resetStats();
+            auto& drawLists = worldRenderer.getDrawListCache();
+            const auto& reused = drawLists.getStats();
+            std::cout << "Draw list reused: " << 100.0 * reused.hitRate() << "% of frames (" <<
+                reused.hits << " as is, " << reused.patches << " patched); CPU time saved: " <<
+                reused.microsecondsSaved / 1000.0 << " ms" << std::endl;
+            drawLists.resetStats();
+            std::cout << "Opaque fragments shaded: " << worldRenderer.getOverdrawStats().fragmentsPerPixel() <<
+                " per pixel" << std::endl;
+            worldRenderer.resetOverdrawStats();
             frametimes.clear();
         }
     }
@@ -68,6 +95,7 @@ void Application::Run() {
 
 void Application::Update(float deltaTime) {
     camera.Update(deltaTime);
+    world.update();
 }
 
 // Define the callback
@@ -126,10 +154,37 @@ void Application::Init() {
     glCullFace(GL_BACK);
     glFrontFace(GL_CCW);
 
+    // driver compiles on its own threads then, programs are only waited for when first constructed
+    if (SDL_GL_ExtensionSupported("GL_KHR_parallel_shader_compile")) {
+        using MaxShaderCompilerThreads = void (APIENTRY*)(GLuint);
+        if (const auto maxThreads = reinterpret_cast<MaxShaderCompilerThreads>(
+            SDL_GL_GetProcAddress("glMaxShaderCompilerThreadsKHR")))
+            maxThreads(0xFFFFFFFF); // as many as the driver likes
+    }
+    Shader::preload({
+        {"shaders/face/vert.glsl", "shaders/face/frag.glsl", "shaders/face/geom.glsl"},
+        {"shaders/face/vert.glsl", "shaders/face/alpha_frag.glsl", "shaders/face/geom.glsl"},
+        {"shaders/skybox/vert.glsl", "shaders/skybox/frag.glsl"},
+        {"shaders/quad/vert.glsl", "shaders/quad/frag.glsl"},
+        {"shaders/debug/vert.glsl", "shaders/debug/frag.glsl"},
+    });
+
     debugRenderer = new debug::DebugRenderer();
-    textureManager.Init("assets/textures/");
+    // packed bundle loads without parsing, asset folders are the fallback while developing
+    if (AssetBundle bundle; bundle.open(AssetBundle::DEFAULT_PATH)) {
+        textureManager.Init(bundle);
+        loadBlocks(bundle, blockRegistry);
+    } else {
+        textureManager.Init("assets/textures/");
+        loadBlocks("assets/models/blocks", "assets/textures/", blockRegistry, textureManager);
+    }
     worldRenderer.init();
 
+    const auto& shaders = Shader::getStartupStats();
+    std::cout << "Shaders ready in " << shaders.microseconds / 1000.0 << " ms (" <<
+        (shaders.compiled ? "cold" : "warm") << " start, " << shaders.cached << " programs from cache, " <<
+        shaders.compiled << " compiled)" << std::endl;
+
 
     std::cout << "OpenGL Vendor: " << glGetString(GL_VENDOR) << "\n"
         << "Renderer: " << glGetString(GL_RENDERER) << "\n"
@@ -170,6 +225,16 @@ bool Application::HandleEvents() {
             if (event.key.key == SDLK_ESCAPE) return false;
             if (event.key.key == SDLK_F5) debugRenderer->switchEnabled();
             if (event.key.key == SDLK_F4) worldRenderer.switchWireframeRendering();
+            if (event.key.key == SDLK_X) Explode(camera.Position, EXPLOSION_RADIUS);
+            if (event.key.key == SDLK_F6) BenchmarkFrustumCulling(CULLING_BENCHMARK_DISTANCE);
+            if (event.key.key == SDLK_F7) BenchmarkDrawSetup();
+            if (event.key.key == SDLK_F9) BenchmarkJobs();
+            if (event.key.key == SDLK_F8) {
+                worldRenderer.resetOverdrawStats();
+                std::cout << "Opaque sections drawn " <<
+                    (worldRenderer.switchDrawOrder() ? "front to back" : "back to front") << std::endl;
+            }
+            if (event.key.key == SDLK_L) world.changeBlock(glm::floor(camera.Position), BlockType::LAMP);
             if (event.key.key == SDLK_B) {
                 captureMouse = !captureMouse;
                 SDL_SetWindowRelativeMouseMode(Window, captureMouse);
@@ -180,6 +245,126 @@ bool Application::HandleEvents() {
 }
 
 
+// Carves a sphere of air through one edit batch, doubles as edit throughput benchmark
+void Application::Explode(const glm::vec3& center, const int radius) {
+    BlockEditBatch batch;
+    const glm::ivec3 c = glm::floor(center);
+    for (int y = std::max(c.y - radius, 0); y <= std::min(c.y + radius, Chunk::HEIGHT - 1); y++)
+        for (int z = c.z - radius; z <= c.z + radius; z++)
+            for (int x = c.x - radius; x <= c.x + radius; x++) {
+                const glm::ivec3 d = glm::ivec3{x, y, z} - c;
+                if (d.x * d.x + d.y * d.y + d.z * d.z <= radius * radius) batch.erase({x, y, z});
+            }
+
+    const Uint64 start = SDL_GetTicksNS();
+    world.apply(batch);
+    const double seconds = (SDL_GetTicksNS() - start) / 1e9;
+    std::cout << "Applied " << batch.size() << " edits over " << batch.getChunks().size() << " chunks in " <<
+        seconds * 1000.0 << " ms (" << batch.size() / seconds << " edits/s)" << std::endl;
+}
+
+// Compares batched frustum culling with testing every sub chunk on its own, camera view as it is now
+void Application::BenchmarkFrustumCulling(const int viewDistance) const {
+    constexpr int REPEATS = 100;
+    const Frustum frustum = camera.getFrustum();
+    const glm::ivec2 center(camera.Position.x / Chunk::WIDTH, camera.Position.z / Chunk::DEPTH);
+
+    std::vector<glm::ivec2> columns;
+    for (int x = -viewDistance; x < viewDistance; x++)
+        for (int z = -viewDistance; z < viewDistance; z++)
+            if (x * x + z * z <= viewDistance * viewDistance) columns.push_back(center + glm::ivec2(x, z));
+
+    std::vector<uint8_t> single(columns.size()), batched(columns.size());
+    Uint64 start = SDL_GetTicksNS();
+    for (int i = 0; i < REPEATS; i++) {
+        for (size_t c = 0; c < columns.size(); c++) {
+            single[c] = 0;
+            for (int y = 0; y < Chunk::SUB_COUNT; y++) {
+                const glm::vec3 min(columns[c].x * Chunk::WIDTH, y * Chunk::SUB_HEIGHT, columns[c].y * Chunk::DEPTH);
+                if (frustum.isAABBVisible({min, min + glm::vec3(Chunk::WIDTH, Chunk::SUB_HEIGHT, Chunk::DEPTH)}))
+                    single[c] |= 1 << y;
+            }
+        }
+    }
+    const double singleNs = static_cast<double>(SDL_GetTicksNS() - start) / REPEATS;
+
+    FrustumCuller culler;
+    culler.setFrustum(frustum);
+    start = SDL_GetTicksNS();
+    for (int i = 0; i < REPEATS; i++) culler.cull(columns, batched);
+    const double batchedNs = static_cast<double>(SDL_GetTicksNS() - start) / REPEATS;
+
+    size_t mismatches = 0;
+    for (size_t c = 0; c < columns.size(); c++) mismatches += single[c] != batched[c];
+    const auto& stats = culler.getStats();
+    std::cout << "Frustum culling of " << columns.size() * Chunk::SUB_COUNT << " sub chunks: " <<
+        singleNs / 1000.0 << " us one by one, " << batchedNs / 1000.0 << " us batched (" << stats.regions <<
+        " regions, " << stats.columns << " columns, " << stats.sections << " sections tested), " <<
+        mismatches << " columns differ" << std::endl;
+}
+
+// Per draw uniform setup of sub chunks, looked up by name on every draw as it used to be and through cached handle
+void Application::BenchmarkDrawSetup() const {
+    const Shader& shader = worldRenderer.getShader();
+    shader.use();
+    const glm::ivec3 coords = glm::floor(camera.Position / static_cast<float>(Chunk::WIDTH));
+
+    Uint64 start = SDL_GetTicksNS();
+    for (int i = 0; i < DRAW_SETUP_BENCHMARK_DRAWS; i++) {
+        const std::string name = "chunkCoords";
+        glUniform3i(glGetUniformLocation(shader.getID(), name.c_str()), coords.x, i & 7, coords.z);
+    }
+    const double lookupNs = static_cast<double>(SDL_GetTicksNS() - start) / DRAW_SETUP_BENCHMARK_DRAWS;
+
+    const auto chunkCoords = shader.getUniform<glm::ivec3>("chunkCoords");
+    start = SDL_GetTicksNS();
+    for (int i = 0; i < DRAW_SETUP_BENCHMARK_DRAWS; i++) chunkCoords.set({coords.x, i & 7, coords.z});
+    const double cachedNs = static_cast<double>(SDL_GetTicksNS() - start) / DRAW_SETUP_BENCHMARK_DRAWS;
+
+    std::cout << "Sub chunk uniform setup: " << lookupNs << " ns per draw looked up by name, " << cachedNs <<
+        " ns per draw through cached location" << std::endl;
+}
+
+// Throughput of tiny jobs submitted from the main thread, and latency from submit until a sleeping worker starts one
+void Application::BenchmarkJobs() const {
+    std::atomic<uint64_t> sum = 0;
+    JobSystem::Counter counter;
+    Uint64 start = SDL_GetTicksNS();
+    for (int i = 0; i < JOB_BENCHMARK_JOBS; i++)
+        jobSystem.submit([&sum, i] { sum.fetch_add(i, std::memory_order_relaxed); }, &counter);
+    jobSystem.wait(counter);
+    const double seconds = (SDL_GetTicksNS() - start) / 1e9;
+
+    std::cout << "Jobs: " << JOB_BENCHMARK_JOBS / seconds / 1e6 << " M/s on " << jobSystem.threadCount() <<
+        " threads" << (sum == uint64_t(JOB_BENCHMARK_JOBS) * (JOB_BENCHMARK_JOBS - 1) / 2 ? "" : " (jobs lost!)") <<
+        std::endl;
+    // nobody but the main thread would run the job
+    if (jobSystem.isSingleThreaded()) return;
+
+    // One job at a time while the main thread spins without helping, so a worker has to wake up
+    // and steal every one of them
+    Uint64 latencySum = 0, latencyMax = 0;
+    int onMain = 0;
+    const std::thread::id mainThread = std::this_thread::get_id();
+    for (int i = 0; i < JOB_BENCHMARK_LATENCY_SAMPLES; i++) {
+        JobSystem::Counter single;
+        Uint64 started = 0;
+        std::thread::id ranOn;
+        start = SDL_GetTicksNS();
+        jobSystem.submit([&started, &ranOn] {
+            started = SDL_GetTicksNS();
+            ranOn = std::this_thread::get_id();
+        }, &single);
+        while (!single.done()) std::this_thread::yield();
+        latencySum += started - start;
+        latencyMax = std::max(latencyMax, started - start);
+        onMain += ranOn == mainThread;
+    }
+    std::cout << "Job wake latency: avg " << latencySum / 1000.0 / JOB_BENCHMARK_LATENCY_SAMPLES << " us, max " <<
+        latencyMax / 1000.0 << " us (" << onMain << " of " << JOB_BENCHMARK_LATENCY_SAMPLES <<
+        " ran on main thread)" << std::endl;
+}
+
 void Application::Render() {
     // Draw
     worldRenderer.render(world, camera);
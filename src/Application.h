@@ -24,6 +24,11 @@ private:
     WorldRenderer worldRenderer{camera};
     World world;
     bool captureMouse = false;
+    static constexpr int EXPLOSION_RADIUS = 24;
+    static constexpr int CULLING_BENCHMARK_DISTANCE = 32;
+    static constexpr int DRAW_SETUP_BENCHMARK_DRAWS = 100000;
+    static constexpr int JOB_BENCHMARK_JOBS = 100000;
+    static constexpr int JOB_BENCHMARK_LATENCY_SAMPLES = 1000;
     void Init();
 
     bool HandleEvents();
@@ -31,6 +36,14 @@ private:
     void Update(float deltaTime);
 
     void Render();
+
+    void Explode(const glm::vec3& center, int radius);
+
+    void BenchmarkFrustumCulling(int viewDistance) const;
+
+    void BenchmarkDrawSetup() const;
+
+    void BenchmarkJobs() const;
 };
 
 #endif //APPLICATION_H
@@ -0,0 +1,127 @@
+#include "AssetBundle.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "BlockLoader.h"
+#include "TextureManager.h"
+
+namespace {
+    uint64_t align(const uint64_t offset) {
+        return (offset + AssetBundle::ALIGNMENT - 1) / AssetBundle::ALIGNMENT * AssetBundle::ALIGNMENT;
+    }
+}
+
+bool AssetBundle::open(const std::string& path) {
+    header = nullptr;
+    if (!file.open(path)) return false;
+
+    // everything is checked once here, so lookups can trust the index
+    const auto bytes = file.bytes();
+    const auto* candidate = reinterpret_cast<const Header*>(bytes.data());
+    if (bytes.size() < sizeof(Header) || candidate->magic != MAGIC || candidate->version != VERSION) {
+        std::cerr << "Asset bundle " << path << " is not of version " << VERSION << ", ignoring it" << std::endl;
+        file.close();
+        return false;
+    }
+    const uint64_t namesStart = sizeof(Header) + static_cast<uint64_t>(candidate->entryCount) * sizeof(Entry);
+    bool valid = namesStart + candidate->namesSize <= bytes.size();
+    const auto* index = reinterpret_cast<const Entry*>(bytes.data() + sizeof(Header));
+    for (uint32_t i = 0; valid && i < candidate->entryCount; i++) {
+        const Entry& entry = index[i];
+        valid = static_cast<uint64_t>(entry.nameOffset) + entry.nameSize <= candidate->namesSize &&
+                entry.offset % ALIGNMENT == 0 && entry.offset <= bytes.size() &&
+                entry.size <= bytes.size() - entry.offset;
+    }
+    if (!valid) {
+        std::cerr << "Asset bundle " << path << " is damaged, ignoring it" << std::endl;
+        file.close();
+        return false;
+    }
+    header = candidate;
+    return true;
+}
+
+std::span<const AssetBundle::Entry> AssetBundle::entries() const {
+    if (!header) return {};
+    return {reinterpret_cast<const Entry*>(file.bytes().data() + sizeof(Header)), header->entryCount};
+}
+
+std::string_view AssetBundle::nameOf(const Entry& entry) const {
+    const auto* names = reinterpret_cast<const char*>(entries().data() + header->entryCount);
+    return {names + entry.nameOffset, entry.nameSize};
+}
+
+std::span<const uint8_t> AssetBundle::dataOf(const Entry& entry) const {
+    return file.bytes().subspan(entry.offset, entry.size);
+}
+
+std::span<const uint8_t> AssetBundle::find(const Kind kind, const std::string_view name) const {
+    for (const Entry& entry : entries()) {
+        if (entry.kind == kind && nameOf(entry) == name) return dataOf(entry);
+    }
+    return {};
+}
+
+void AssetBundle::pack(const std::string& assetsDir, const std::string& path) {
+    const std::string textureDir = assetsDir + "/textures/";
+    const TextureManager::Decoded textures = TextureManager::decode(textureDir);
+    std::map<std::string, GLuint> layers;
+    for (size_t layer = 0; layer < textures.names.size(); layer++)
+        layers.emplace(textures.names[layer], static_cast<GLuint>(layer));
+    const BlockDefinitions blocks = parseBlocks(assetsDir + "/models/blocks", textureDir, layers);
+
+    struct Item {
+        Kind kind;
+        std::string name;
+        std::span<const uint8_t> data;
+    };
+    std::vector<Item> items;
+    for (int level = 0; level < TextureManager::MIPMAP_LEVELS; level++)
+        items.push_back({Kind::TEXTURE_LEVEL, std::to_string(level), textures.levels[level]});
+    for (const auto& name : textures.names)
+        items.push_back({Kind::TEXTURE, name, {}});
+    std::vector<PackedBlock> packedBlocks(blocks.size());
+    for (size_t i = 0; i < blocks.size(); i++) {
+        const BlockProperties& properties = blocks[i].second;
+        PackedBlock& block = packedBlocks[i];
+        block = {properties.opaque, properties.solid, properties.emission,
+                 static_cast<uint8_t>(properties.renderLayer), {}};
+        std::copy(properties.layers.begin(), properties.layers.end(), block.layers);
+        items.push_back({Kind::BLOCK, blocks[i].first,
+                         {reinterpret_cast<const uint8_t*>(&block), sizeof(block)}});
+    }
+
+    std::vector<Entry> index;
+    std::string names;
+    for (const Item& item : items) {
+        index.push_back({item.kind, static_cast<uint32_t>(names.size()), static_cast<uint32_t>(item.name.size()),
+                         0, 0, item.data.size()});
+        names += item.name;
+    }
+    uint64_t offset = align(sizeof(Header) + index.size() * sizeof(Entry) + names.size());
+    for (Entry& entry : index) {
+        entry.offset = offset;
+        offset = align(offset + entry.size);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("Can not write asset bundle " + path);
+    const Header header{MAGIC, VERSION, static_cast<uint32_t>(index.size()), static_cast<uint32_t>(names.size())};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(Entry)));
+    out.write(names.data(), static_cast<std::streamsize>(names.size()));
+    for (size_t i = 0; i < items.size(); i++) {
+        const auto position = static_cast<uint64_t>(out.tellp());
+        const std::vector<char> padding(index[i].offset - position, 0);
+        out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        out.write(reinterpret_cast<const char*>(items[i].data.data()), static_cast<std::streamsize>(items[i].data.size()));
+    }
+    if (!out) throw std::runtime_error("Can not write asset bundle " + path);
+
+    std::cout << "Packed " << textures.names.size() << " textures and " << blocks.size() << " blocks into "
+              << path << " (" << offset << " bytes)" << std::endl;
+}
@@ -0,0 +1,84 @@
+#ifndef ASSETBUNDLE_H
+#define ASSETBUNDLE_H
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "utils/MappedFile.hpp"
+
+// Block definitions and decoded textures packed into one file, made by `--pack-assets`.
+// File is mapped and read in place: header, index of entries, names, then entry data aligned to
+// ALIGNMENT. Loading it parses nothing, so startup does not grow with the amount of content.
+// Without a bundle the game reads the asset folders directly
+class AssetBundle {
+public:
+    static constexpr uint32_t MAGIC = 0x42415856; // "VXAB"
+    // bump whenever layout of the file or of any entry changes
+    static constexpr uint32_t VERSION = 2;
+    static constexpr size_t ALIGNMENT = 16;
+    // next to the assets folder, loaded instead of it when present
+    static constexpr const char* DEFAULT_PATH = "assets.bundle";
+
+    enum class Kind : uint32_t {
+        // all layers of one mip level, named by the level
+        TEXTURE_LEVEL,
+        // texture layer, named by path, in layer order and without data
+        TEXTURE,
+        // PackedBlock, named by block name
+        BLOCK,
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t namesSize;
+    };
+
+    struct Entry {
+        Kind kind;
+        uint32_t nameOffset;
+        uint32_t nameSize;
+        uint32_t padding;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct PackedBlock {
+        uint8_t opaque;
+        uint8_t solid;
+        uint8_t emission;
+        uint8_t renderLayer;
+        uint16_t layers[6];
+    };
+
+    // Maps bundle at path, false when there is none or it was packed by another version
+    bool open(const std::string& path);
+
+    bool isOpen() const { return header != nullptr; }
+
+    // data of the first entry of kind with name, empty when there is none
+    std::span<const uint8_t> find(Kind kind, std::string_view name) const;
+
+    // Visits name and data of every entry of kind, in packed order
+    template <typename Visit>
+    void forEach(const Kind kind, Visit&& visit) const {
+        for (const Entry& entry : entries()) {
+            if (entry.kind == kind) visit(nameOf(entry), dataOf(entry));
+        }
+    }
+
+    // Packs assets folder into a bundle at path
+    static void pack(const std::string& assetsDir, const std::string& path);
+
+private:
+    MappedFile file;
+    const Header* header = nullptr;
+
+    std::span<const Entry> entries() const;
+    std::string_view nameOf(const Entry& entry) const;
+    std::span<const uint8_t> dataOf(const Entry& entry) const;
+};
+
+#endif //ASSETBUNDLE_H
@@ -0,0 +1,92 @@
+#include "BlockLoader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+#include "AssetBundle.h"
+#include "JsonLoader.h"
+#include "TextureManager.h"
+
+namespace {
+    // texture keys of a definition, later keys override earlier ones
+    constexpr std::pair<const char*, uint8_t> TEXTURE_KEYS[] = {
+        {"all", 0b111111},
+        {"side", 1 << WEST | 1 << EAST | 1 << SOUTH | 1 << NORTH},
+        {"top", 1 << UP}, {"bottom", 1 << DOWN},
+        {"west", 1 << WEST}, {"east", 1 << EAST}, {"south", 1 << SOUTH}, {"north", 1 << NORTH},
+        {"up", 1 << UP}, {"down", 1 << DOWN},
+    };
+
+    constexpr std::pair<const char*, RenderLayer> RENDER_LAYER_NAMES[] = {
+        {"opaque", RenderLayer::OPAQUE}, {"cutout", RenderLayer::CUTOUT}, {"translucent", RenderLayer::TRANSLUCENT},
+    };
+
+    BlockProperties parseBlock(const json& definition, const std::string& textureDir,
+                               const std::map<std::string, GLuint>& layers) {
+        BlockProperties properties;
+        properties.opaque = definition.value("opaque", properties.opaque);
+        properties.solid = definition.value("solid", properties.solid);
+        // block light is 4 bits, out of range values are clamped to it
+        properties.emission = std::clamp(definition.value("emission", 0), 0, 15);
+        // blocks light passes through have holes by default
+        const std::string render = definition.value("render", properties.opaque ? "opaque" : "cutout");
+        const auto layer = std::find_if(std::begin(RENDER_LAYER_NAMES), std::end(RENDER_LAYER_NAMES),
+                                        [&](const auto& entry) { return render == entry.first; });
+        if (layer == std::end(RENDER_LAYER_NAMES)) throw std::runtime_error("Unknown render layer " + render);
+        properties.renderLayer = layer->second;
+
+        if (const auto it = definition.find("textures"); it != definition.end()) {
+            for (const auto& [key, faces] : TEXTURE_KEYS) {
+                if (!it->contains(key)) continue;
+                const std::string texture = textureDir + (*it)[key].get<std::string>();
+                const auto layer = layers.find(texture);
+                if (layer == layers.end()) throw std::runtime_error("Texture " + texture + " is not loaded");
+                for (int face = 0; face < 6; face++)
+                    if (faces & 1 << face) properties.layers[face] = static_cast<uint16_t>(layer->second);
+            }
+        }
+        return properties;
+    }
+}
+
+BlockDefinitions parseBlocks(const std::string& dir, const std::string& textureDir,
+                             const std::map<std::string, GLuint>& layers) {
+    const JsonLoader loader(dir);
+    BlockDefinitions definitions;
+    // map keeps paths sorted, so new blocks get the same ids on every start
+    for (const auto& [path, definition] : loader.getJsons()) {
+        try {
+            std::string name = definition.value(
+                "name", std::filesystem::path(path).stem().string());
+            definitions.emplace_back(std::move(name), parseBlock(definition, textureDir, layers));
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid block definition " << path << ": " << e.what() << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    return definitions;
+}
+
+void loadBlocks(const std::string& dir, const std::string& textureDir,
+                BlockRegistry& registry, const TextureManager& textures) {
+    for (const auto& [name, properties] : parseBlocks(dir, textureDir, textures.getTextureLayers()))
+        registry.define(name, properties);
+}
+
+void loadBlocks(const AssetBundle& bundle, BlockRegistry& registry) {
+    bundle.forEach(AssetBundle::Kind::BLOCK, [&](const std::string_view name, const std::span<const uint8_t> data) {
+        AssetBundle::PackedBlock block;
+        if (data.size() == sizeof(block)) std::memcpy(&block, data.data(), sizeof(block));
+        if (data.size() != sizeof(block) || block.renderLayer >= RENDER_LAYERS) {
+            std::cerr << "Invalid block " << name << " in asset bundle" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        BlockProperties properties{block.opaque != 0, block.solid != 0, block.emission};
+        std::copy(std::begin(block.layers), std::end(block.layers), properties.layers.begin());
+        properties.renderLayer = static_cast<RenderLayer>(block.renderLayer);
+        registry.define(std::string(name), properties);
+    });
+}
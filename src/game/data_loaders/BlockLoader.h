@@ -0,0 +1,29 @@
+#ifndef BLOCKLOADER_H
+#define BLOCKLOADER_H
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "game/world/BlockRegistry.hpp"
+
+class AssetBundle;
+class TextureManager;
+
+// block name and properties, in file order
+using BlockDefinitions = std::vector<std::pair<std::string, BlockProperties>>;
+
+// Parses every .json block of dir. Texture names are resolved against textureDir into layers
+BlockDefinitions parseBlocks(const std::string& dir, const std::string& textureDir,
+                             const std::map<std::string, GLuint>& layers);
+
+// Defines blocks of dir, textures must be loaded already so faces get their array layers
+void loadBlocks(const std::string& dir, const std::string& textureDir,
+                BlockRegistry& registry, const TextureManager& textures);
+
+// Defines blocks packed in bundle
+void loadBlocks(const AssetBundle& bundle, BlockRegistry& registry);
+
+#endif //BLOCKLOADER_H
@@ -1,7 +1,7 @@
 #include "JsonLoader.h"
 
+#include <filesystem>
 #include <fstream>
-#include <iostream>
 
 JsonLoader::JsonLoader(const std::string& dir) {
     for (const auto entry : std::filesystem::recursive_directory_iterator(dir)) {
@@ -9,8 +9,5 @@ JsonLoader::JsonLoader(const std::string& dir) {
         if (entry.path().extension() != ".json") continue;
 
         jsons.emplace(entry.path().string(), json::parse(std::ifstream(entry.path())));
-
-        std::cout << entry.path() << ' ' << jsons[entry.path().string()] << std::endl;
-
     }
 }
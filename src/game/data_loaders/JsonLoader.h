@@ -10,6 +10,9 @@ class JsonLoader {
     std::map<std::string, json> jsons;
 public:
     explicit JsonLoader(const std::string &dir);
+
+    // parsed files by path
+    const std::map<std::string, json>& getJsons() const { return jsons; }
 };
 
 
@@ -1,46 +1,109 @@
 #include "TextureManager.h"
 
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 
+#include "AssetBundle.h"
 #include "../../../3rdparty/stb_image.h"
 #include "../../Application.h"
 #include "render/utils.h"
+#include "utils/ParallelFor.hpp"
 
 constexpr int LAYER_COUNT =
     2048;  // Opengl 4.5 provides at least that number of layers
-constexpr int MIPMAP_LEVELS = 4;
-constexpr int TEXTURE_WIDTH = 16;
-constexpr int TEXTURE_HEIGHT = 16;
+constexpr int MIPMAP_LEVELS = TextureManager::MIPMAP_LEVELS;
+constexpr int TEXTURE_WIDTH = TextureManager::TEXTURE_WIDTH;
+constexpr int TEXTURE_HEIGHT = TextureManager::TEXTURE_HEIGHT;
 
-void TextureManager::Init(const std::string& folder_path) {
-    glGenTextures(1, &textureArray);
-    if (auto err = glGetError(); err != GL_NO_ERROR) {
-        std::cerr << "Error during loading texture in line " << __LINE__ << ": "
-                  << err << std::endl;
-        exit(EXIT_FAILURE);
+namespace {
+    // whole array with its mips is baked here, by hash of texture files
+    const std::filesystem::path CACHE_PATH = "texture_cache/blocks.bin";
+    constexpr uint32_t CACHE_MAGIC = 0x31584554; // "TEX1"
+
+    void checkError(const int line) {
+        if (auto err = glGetError(); err != GL_NO_ERROR) {
+            std::cerr << "Error during loading texture in line " << line << ": "
+                      << err << std::endl;
+            exit(EXIT_FAILURE);
+        }
     }
 
-    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
-    if (auto err = glGetError(); err != GL_NO_ERROR) {
-        std::cerr << "Error during loading texture in line " << __LINE__ << ": "
-                  << err << std::endl;
-        exit(EXIT_FAILURE);
+    uint64_t fnv1a(const void* data, const size_t size, uint64_t hash = 14695981039346656037ull) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 1099511628211ull;
+        return hash;
     }
 
-    glTexStorage3D(GL_TEXTURE_2D_ARRAY, MIPMAP_LEVELS, GL_RGBA8, TEXTURE_WIDTH,
-                   TEXTURE_HEIGHT, LAYER_COUNT);
-    if (auto err = glGetError(); err != GL_NO_ERROR) {
-        std::cerr << "Error during loading texture in line " << __LINE__ << ": "
-                  << err << std::endl;
-        exit(EXIT_FAILURE);
+    // changes whenever a texture is added, removed or touched
+    uint64_t hashFiles(const std::vector<std::string>& files) {
+        uint64_t hash = fnv1a(&CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        for (const auto& file : files) {
+            const auto size = static_cast<uint64_t>(std::filesystem::file_size(file));
+            const auto time = std::filesystem::last_write_time(file).time_since_epoch().count();
+            hash = fnv1a(file.data(), file.size() + 1, hash);
+            hash = fnv1a(&size, sizeof(size), hash);
+            hash = fnv1a(&time, sizeof(time), hash);
+        }
+        return hash;
     }
 
-    stbi_set_flip_vertically_on_load(1);
+    using Levels = std::array<std::vector<uint8_t>, MIPMAP_LEVELS>;
 
-    int layer = 0;
+    // 2x2 box filter of the level above, same as the driver does it for power of two sizes
+    void generateMips(Levels& levels, const size_t layer) {
+        for (int level = 1; level < MIPMAP_LEVELS; level++) {
+            const int width = TEXTURE_WIDTH >> level;
+            const int height = TEXTURE_HEIGHT >> level;
+            const uint8_t* src = levels[level - 1].data() + TextureManager::levelSize(level - 1) * layer;
+            uint8_t* dst = levels[level].data() + TextureManager::levelSize(level) * layer;
+            for (int y = 0; y < height; y++)
+                for (int x = 0; x < width; x++)
+                    for (int c = 0; c < 4; c++) {
+                        const auto at = [&](const int dx, const int dy) {
+                            return src[((y * 2 + dy) * width * 2 + x * 2 + dx) * 4 + c];
+                        };
+                        dst[(y * width + x) * 4 + c] =
+                            static_cast<uint8_t>((at(0, 0) + at(1, 0) + at(0, 1) + at(1, 1) + 2) / 4);
+                    }
+        }
+    }
+
+    bool loadCache(const uint64_t hash, Levels& levels, const size_t layers) {
+        std::ifstream file(CACHE_PATH, std::ios::binary);
+        if (!file) return false;
+        uint32_t magic = 0;
+        uint64_t fileHash = 0, fileLayers = 0;
+        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        file.read(reinterpret_cast<char*>(&fileHash), sizeof(fileHash));
+        file.read(reinterpret_cast<char*>(&fileLayers), sizeof(fileLayers));
+        if (!file || magic != CACHE_MAGIC || fileHash != hash || fileLayers != layers) return false;
+        for (auto& level : levels)
+            file.read(reinterpret_cast<char*>(level.data()), static_cast<std::streamsize>(level.size()));
+        return static_cast<bool>(file);
+    }
 
+    void saveCache(const uint64_t hash, const Levels& levels, const size_t layers) {
+        std::error_code error;
+        std::filesystem::create_directories(CACHE_PATH.parent_path(), error);
+        std::ofstream file(CACHE_PATH, std::ios::binary | std::ios::trunc);
+        if (!file) return;
+        const uint64_t fileLayers = layers;
+        file.write(reinterpret_cast<const char*>(&CACHE_MAGIC), sizeof(CACHE_MAGIC));
+        file.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+        file.write(reinterpret_cast<const char*>(&fileLayers), sizeof(fileLayers));
+        for (const auto& level : levels)
+            file.write(reinterpret_cast<const char*>(level.data()), static_cast<std::streamsize>(level.size()));
+    }
+}
+
+TextureManager::Decoded TextureManager::decode(const std::string& folder_path) {
+    Decoded result;
+    auto& files = result.names;
     for (const auto& file :
          std::filesystem::recursive_directory_iterator(folder_path)) {
         if (file.is_directory()) continue;
@@ -53,65 +116,124 @@ void TextureManager::Init(const std::string& folder_path) {
                       << " not supported";
             exit(EXIT_FAILURE);
         }
+        files.push_back(std::move(filename));
+    }
+    // layers do not depend on directory order, so the cache stays valid
+    std::sort(files.begin(), files.end());
+    if (files.size() > LAYER_COUNT) {
+        std::cerr << "Too many textures: " << files.size() << ", at most "
+                  << LAYER_COUNT << " fit in texture array" << std::endl;
+        exit(EXIT_FAILURE);
+    }
 
+    auto& levels = result.levels;
+    for (int level = 0; level < MIPMAP_LEVELS; level++) levels[level].resize(levelSize(level) * files.size());
+    const uint64_t hash = hashFiles(files);
+    result.cached = loadCache(hash, levels, files.size());
+    if (result.cached) return result;
+
+    // empty on success
+    std::vector<std::string> errors(files.size());
+    stbi_set_flip_vertically_on_load(1);
+    parallelFor(files.size(), [&](const size_t layer) {
+        const std::string& filename = files[layer];
         int w, h, channels;
         unsigned char* data =
             stbi_load(filename.c_str(), &w, &h, &channels, STBI_rgb_alpha);
         if (!data) {
-            std::cerr << "Failed to load texture: " << filename << std::endl;
-            std::cerr << stbi_failure_reason() << std::endl;
-            exit(EXIT_FAILURE);
+            errors[layer] = "Failed to load texture: " + filename + '\n' + stbi_failure_reason();
+            return;
         }
-
         if (w != TEXTURE_WIDTH || h != TEXTURE_HEIGHT || channels != 4) {
-            std::cerr << "Failed to load texture: " << filename << std::endl;
-            std::cerr << "Invalid size:" << std::endl;
-            std::cerr << "Got: " << w << 'x' << h << std::endl;
-            std::cerr << "Expected size: " << TEXTURE_WIDTH << 'x'
-                      << TEXTURE_HEIGHT << std::endl;
-            exit(EXIT_FAILURE);
+            errors[layer] = "Failed to load texture: " + filename + "\nInvalid size:\nGot: " +
+                            std::to_string(w) + 'x' + std::to_string(h) + "\nExpected size: " +
+                            std::to_string(TEXTURE_WIDTH) + 'x' + std::to_string(TEXTURE_HEIGHT);
+        } else {
+            std::memcpy(levels[0].data() + levelSize(0) * layer, data, levelSize(0));
+            generateMips(levels, layer);
         }
+        stbi_image_free(data);
+    }, 8);
+    stbi_set_flip_vertically_on_load(0);
 
-        glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+    for (const auto& error : errors) {
+        if (error.empty()) continue;
+        std::cerr << error << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    saveCache(hash, levels, files.size());
+    return result;
+}
 
-        if (auto err = glGetError(); err != GL_NO_ERROR) {
-            std::cerr << "Error during loading texture in line " << __LINE__
-                      << ": " << err << std::endl;
-            exit(EXIT_FAILURE);
-        }
+void TextureManager::Init(const std::string& folder_path) {
+    const auto startTime = std::chrono::steady_clock::now();
 
-        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, TEXTURE_WIDTH,
-                        TEXTURE_HEIGHT, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    const Decoded decoded = decode(folder_path);
+    std::array<const uint8_t*, MIPMAP_LEVELS> levels{};
+    for (int level = 0; level < MIPMAP_LEVELS; level++) levels[level] = decoded.levels[level].data();
+    upload(decoded.names, levels);
 
-        if (auto err = glGetError(); err != GL_NO_ERROR) {
-            std::cerr << "Error during loading texture in line " << __LINE__
-                      << ": " << err << std::endl;
-            exit(EXIT_FAILURE);
-        }
+    const auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Loaded " << decoded.names.size() << " textures in " << elapsed << " ms ("
+              << (decoded.cached ? "from cache" : "decoded") << ")" << std::endl;
+}
 
-        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
-                        GL_NEAREST_MIPMAP_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+void TextureManager::Init(const AssetBundle& bundle) {
+    const auto startTime = std::chrono::steady_clock::now();
 
-        if (auto err = glGetError(); err != GL_NO_ERROR) {
-            std::cerr << "Error during loading texture in line " << __LINE__
-                      << ": " << err << std::endl;
+    // layers are stored in the order textures were packed
+    std::vector<std::string> names;
+    bundle.forEach(AssetBundle::Kind::TEXTURE, [&](const std::string_view name, std::span<const uint8_t>) {
+        names.emplace_back(name);
+    });
+    std::array<const uint8_t*, MIPMAP_LEVELS> levels{};
+    for (int level = 0; level < MIPMAP_LEVELS; level++) {
+        const auto data = bundle.find(AssetBundle::Kind::TEXTURE_LEVEL, std::to_string(level));
+        if (data.size() != levelSize(level) * names.size()) {
+            std::cerr << "Asset bundle has no valid mip level " << level << std::endl;
             exit(EXIT_FAILURE);
         }
-        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
-        if (auto err = glGetError(); err != GL_NO_ERROR) {
-            std::cerr << "Error generating mipmaps: " << err << std::endl;
-            exit(EXIT_FAILURE);
-        }
-        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
-        stbi_image_free(data);
+        levels[level] = data.data();
+    }
+    upload(names, levels);
+
+    const auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Loaded " << names.size() << " textures in " << elapsed << " ms (from bundle)" << std::endl;
+}
 
-        textureMap.emplace(filename, layer++);
+void TextureManager::upload(const std::vector<std::string>& names,
+                            const std::array<const uint8_t*, MIPMAP_LEVELS>& levels) {
+    glGenTextures(1, &textureArray);
+    checkError(__LINE__);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+    checkError(__LINE__);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, MIPMAP_LEVELS, GL_RGBA8, TEXTURE_WIDTH,
+                   TEXTURE_HEIGHT, LAYER_COUNT);
+    checkError(__LINE__);
+
+    // one upload per mip level for all layers, mips were made on the CPU so nothing is regenerated
+    if (!names.empty()) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (int level = 0; level < MIPMAP_LEVELS; level++)
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, TEXTURE_WIDTH >> level,
+                            TEXTURE_HEIGHT >> level, static_cast<GLsizei>(names.size()),
+                            GL_RGBA, GL_UNSIGNED_BYTE, levels[level]);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        checkError(__LINE__);
     }
 
-    stbi_set_flip_vertically_on_load(0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                    GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    checkError(__LINE__);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    for (size_t layer = 0; layer < names.size(); layer++)
+        textureMap.emplace(names[layer], static_cast<GLuint>(layer));
 }
 
 GLuint TextureManager::getTextureLayer(const std::string& name) const {
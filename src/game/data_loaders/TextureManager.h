@@ -1,12 +1,16 @@
 #ifndef TEXTUREMANAGER_H
 #define TEXTUREMANAGER_H
 
+#include <array>
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
 
 #include <glad/glad.h>
 
+class AssetBundle;
+
 class TextureManager {
     GLuint textureArray = 0;
 
@@ -14,17 +18,45 @@ class TextureManager {
     std::vector<GLuint> additionalTextures;
 
 public:
+    static constexpr int MIPMAP_LEVELS = 4;
+    static constexpr int TEXTURE_WIDTH = 16;
+    static constexpr int TEXTURE_HEIGHT = 16;
+
+    // bytes of one layer of mip level
+    static constexpr size_t levelSize(const int level) {
+        return static_cast<size_t>(TEXTURE_WIDTH >> level) * (TEXTURE_HEIGHT >> level) * 4;
+    }
+
+    // Textures of a folder decoded on the CPU, every mip level holds all layers one after another
+    struct Decoded {
+        std::vector<std::string> names;
+        std::array<std::vector<uint8_t>, MIPMAP_LEVELS> levels;
+        bool cached = false;
+    };
+
+    // Decodes textures of folder in parallel, or reads them from the baked cache when the files did not change
+    static Decoded decode(const std::string& folder_path);
+
     void Init(const std::string& folder_path);
 
+    // Uploads textures of the bundle straight from its mapping
+    void Init(const AssetBundle& bundle);
+
     GLuint getTextureLayer(const std::string& name) const;
 
     GLuint getTextureArray() const { return textureArray; };
 
+    const std::map<std::string, GLuint>& getTextureLayers() const { return textureMap; }
+
     GLuint loadTexture2D(const std::string& name,
         GLuint internalFormat = GL_RGB, GLuint type = GL_UNSIGNED_BYTE,
         GLuint minFilter = GL_NEAREST_MIPMAP_NEAREST, GLuint magFilter = GL_NEAREST);
 
     ~TextureManager();
+
+private:
+    void upload(const std::vector<std::string>& names,
+                const std::array<const uint8_t*, MIPMAP_LEVELS>& levels);
 };
 
 
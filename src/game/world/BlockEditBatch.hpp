@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Chunk.h"
+
+// Block changes queued to be applied together by World::apply.
+// Nothing is visible in the world until then. Edits are grouped by chunk as they come,
+// so applying the batch needs no sorting and every chunk can be written independently
+class BlockEditBatch {
+public:
+    struct Edit {
+        uint32_t index; // ChunkData::getIndex of the block
+        BlockType type;
+    };
+
+    // Chunk edges, neighbour sections touched by edges are invalidated too
+    enum Edge { EDGE_X_MIN, EDGE_X_MAX, EDGE_Z_MIN, EDGE_Z_MAX };
+    // Corner columns, diagonal neighbours read them for AO
+    enum Corner { CORNER_X_MIN_Z_MIN, CORNER_X_MAX_Z_MIN, CORNER_X_MIN_Z_MAX, CORNER_X_MAX_Z_MAX };
+
+    struct ChunkEdits {
+        glm::ivec2 coords;
+        // applied in queue order, so the last edit of a block wins
+        std::vector<Edit> edits;
+        uint8_t sections = 0;
+        std::array<uint8_t, 4> edges{};
+        std::array<uint8_t, 4> corners{};
+    };
+
+    // Edits above or below the world are ignored, there is no block to change
+    void set(const glm::ivec3& pos, BlockType type) {
+        if (pos.y < 0 || pos.y >= Chunk::HEIGHT) return;
+        const glm::ivec2 coords = Chunk::getChunkCoords(pos);
+        const glm::ivec3 local{pos.x - coords.x * Chunk::WIDTH, pos.y, pos.z - coords.y * Chunk::DEPTH};
+
+        auto [it, inserted] = chunkIndex.try_emplace(Chunk::getId(coords.x, coords.y), chunks.size());
+        if (inserted) chunks.push_back({coords});
+        ChunkEdits& chunk = chunks[it->second];
+
+        chunk.edits.push_back({static_cast<uint32_t>(ChunkData::getIndex(local)), type});
+
+        const uint8_t sections = ChunkData::sectionMask(pos.y);
+        chunk.sections |= sections;
+        if (local.x == 0) chunk.edges[EDGE_X_MIN] |= sections;
+        if (local.x == Chunk::WIDTH - 1) chunk.edges[EDGE_X_MAX] |= sections;
+        if (local.z == 0) chunk.edges[EDGE_Z_MIN] |= sections;
+        if (local.z == Chunk::DEPTH - 1) chunk.edges[EDGE_Z_MAX] |= sections;
+        if ((local.x == 0 || local.x == Chunk::WIDTH - 1) && (local.z == 0 || local.z == Chunk::DEPTH - 1))
+            chunk.corners[(local.x != 0) + 2 * (local.z != 0)] |= sections;
+        count++;
+    }
+
+    void erase(const glm::ivec3& pos) { set(pos, BlockType::AIR); }
+
+    void clear() {
+        chunks.clear();
+        chunkIndex.clear();
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const std::vector<ChunkEdits>& getChunks() const { return chunks; }
+
+private:
+    std::vector<ChunkEdits> chunks;
+    // Chunk::getId -> index into chunks
+    std::unordered_map<size_t, size_t> chunkIndex;
+    size_t count = 0;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "BlockType.h"
+#include "EFacing.h"
+
+// Pass the faces of a block are drawn in, meshes keep a separate range for each
+enum class RenderLayer : uint8_t {
+    OPAQUE,
+    // alpha tested, holes are discarded but the rest is opaque (leaves)
+    CUTOUT,
+    // alpha blended, drawn back to front after everything else (glass, water)
+    TRANSLUCENT,
+};
+inline constexpr int RENDER_LAYERS = 3;
+
+// Properties of one block type, as defined in assets/models/blocks
+struct BlockProperties {
+    // light can not pass through and faces behind it are hidden
+    bool opaque = true;
+    // entities collide with it
+    bool solid = true;
+    // block light level the block emits, 0..15
+    uint8_t emission = 0;
+    // texture array layer of every face, indexed by Facing
+    std::array<uint16_t, 6> layers{};
+    // only used by blocks which are not opaque, opaque ones are always drawn in the opaque pass
+    RenderLayer renderLayer = RenderLayer::OPAQUE;
+};
+
+// Properties of all block types as flat tables indexed by block id, so meshing, light and culling
+// look them up without branching on the type
+struct BlockTable {
+    static constexpr size_t MAX_TYPES = 256;
+
+    std::array<bool, MAX_TYPES> opaque{};
+    std::array<bool, MAX_TYPES> solid{};
+    std::array<uint8_t, MAX_TYPES> emission{};
+    std::array<std::array<uint16_t, 6>, MAX_TYPES> layers{};
+    std::array<RenderLayer, MAX_TYPES> renderLayer{};
+
+    constexpr void set(const BlockType type, const BlockProperties& properties) {
+        const auto id = static_cast<size_t>(type);
+        opaque[id] = properties.opaque;
+        solid[id] = properties.solid;
+        emission[id] = properties.emission;
+        layers[id] = properties.layers;
+        renderLayer[id] = properties.opaque ? RenderLayer::OPAQUE : properties.renderLayer;
+    }
+};
+
+// built-in blocks in BlockType order, loaded definitions may override them
+inline constexpr std::array<std::string_view, 5> BUILTIN_BLOCK_NAMES = {"air", "dirt", "grass", "stone", "lamp"};
+
+inline constexpr BlockTable BUILTIN_BLOCKS = [] {
+    BlockTable table;
+    table.set(BlockType::AIR, {.opaque = false, .solid = false});
+    table.set(BlockType::DIRT, {});
+    table.set(BlockType::GRASS, {});
+    table.set(BlockType::STONE, {});
+    table.set(BlockType::LAMP, {.emission = 15});
+    return table;
+}();
+
+// Block types by name. Starts with the built-in table and grows with definitions loaded at startup,
+// tables must not change once chunks are generated
+class BlockRegistry {
+public:
+    BlockTable table = BUILTIN_BLOCKS;
+
+    BlockRegistry() {
+        for (size_t id = 0; id < BUILTIN_BLOCK_NAMES.size(); id++)
+            ids.emplace(BUILTIN_BLOCK_NAMES[id], static_cast<BlockType>(id));
+    }
+
+    // Defines block of given name, or redefines it when it exists already
+    BlockType define(const std::string& name, const BlockProperties& properties) {
+        auto it = ids.find(name);
+        if (it == ids.end()) {
+            if (ids.size() >= BlockTable::MAX_TYPES)
+                throw std::runtime_error("Too many block types, can not define " + name);
+            it = ids.emplace(name, static_cast<BlockType>(ids.size())).first;
+        }
+        table.set(it->second, properties);
+        return it->second;
+    }
+
+    std::optional<BlockType> find(const std::string& name) const {
+        const auto it = ids.find(name);
+        if (it == ids.end()) return std::nullopt;
+        return it->second;
+    }
+
+    size_t size() const { return ids.size(); }
+
+private:
+    std::unordered_map<std::string, BlockType> ids;
+};
+
+inline BlockRegistry blockRegistry{};
+
+// Blocks light can not pass through
+inline bool isOpaque(const BlockType type) {
+    return blockRegistry.table.opaque[static_cast<size_t>(type)];
+}
+
+inline bool isSolid(const BlockType type) {
+    return blockRegistry.table.solid[static_cast<size_t>(type)];
+}
+
+// Block light level the block emits, 0..15
+inline uint8_t getLightEmission(const BlockType type) {
+    return blockRegistry.table.emission[static_cast<size_t>(type)];
+}
+
+inline RenderLayer getRenderLayer(const BlockType type) {
+    return blockRegistry.table.renderLayer[static_cast<size_t>(type)];
+}
+
+inline uint16_t getTextureLayer(const BlockType type, const Facing facing) {
+    return blockRegistry.table.layers[static_cast<size_t>(type)][facing];
+}
@@ -2,6 +2,8 @@
 
 #include <SDL3/SDL_stdinc.h>
 
+// Id of a block type. Named values are the built-in blocks, ids past them are
+// handed out by BlockRegistry to blocks loaded from assets
 enum class BlockType : uint32_t {
-    AIR, DIRT, GRASS, STONE
+    AIR, DIRT, GRASS, STONE, LAMP
 };
@@ -1,37 +1,31 @@
 #pragma once
 
 #include "ChunkData.hpp"
+#include "ChunkLight.hpp"
 #include "render/Frustum.h"
+#include "utils/Morton.hpp"
+
+// Lifecycle of a loaded chunk
+enum class ChunkState : uint8_t {
+    QUEUED, // slot reserved, blocks are not generated yet
+    GENERATED, // blocks generated, no mesh
+    UPLOADED, // mesh built and written to GPU mesh pool, in the same step
+    EVICTABLE, // out of keep range, stays loaded until memory budget needs it back
+};
 
 class Chunk {
 public:
     static constexpr int WIDTH = ChunkData::WIDTH;
     static constexpr int HEIGHT = ChunkData::HEIGHT;
     static constexpr int DEPTH = ChunkData::DEPTH;
-    static constexpr int SUB_HEIGHT = ChunkData::WIDTH;
-    static constexpr int SUB_COUNT = HEIGHT / SUB_HEIGHT;
+    static constexpr int SUB_HEIGHT = ChunkData::SUB_HEIGHT;
+    static constexpr int SUB_COUNT = ChunkData::SUB_COUNT;
 
 private:
     AABB box;
 
-    static uint64_t mortonEncode(uint32_t x, uint32_t z) {
-        uint64_t morton = 0;
-        for (int i = 0; i < 21; ++i) {
-            morton |= ((uint64_t)(x & 1) << (2 * i));
-            morton |= ((uint64_t)(z & 1) << (2 * i + 1));
-            x >>= 1;
-            z >>= 1;
-        }
-        return morton;
-    }
-
-    static void mortonDecode(uint64_t morton, uint32_t& x, uint32_t& z) {
-        x = 0;
-        z = 0;
-        for (int i = 0; i < 21; ++i) {
-            x |= ((morton >> (2 * i)) & 1) << i;
-            z |= ((morton >> (2 * i + 1)) & 1) << i;
-        }
+    static int floorDiv(int a, int b) {
+        return a / b - (a % b != 0 && (a < 0) != (b < 0));
     }
 
 public:
@@ -39,6 +33,9 @@ public:
     int zCoord; //chunk coordinate
 
     ChunkData data;
+    ChunkLight light;
+
+    ChunkState state = ChunkState::QUEUED;
 
     explicit Chunk(glm::ivec2 coords) : xCoord(coords.x), zCoord(coords.y),
                                         box{
@@ -50,17 +47,26 @@ public:
 
     Chunk(Chunk&& other) noexcept : box(other.box) {
         data = std::move(other.data);
+        light = std::move(other.light);
         xCoord = other.xCoord;
         zCoord = other.zCoord;
+        state = other.state;
     }
 
     size_t getId() const {
         return Chunk::getId(xCoord, zCoord);
     }
 
+    // coordinates are offset to fit Morton code unsigned (handles ±1M chunks)
+    static constexpr uint32_t ID_OFFSET = 1 << 20;
+
     static size_t getId(unsigned int xCoord, unsigned int zCoord) {
-        constexpr uint64_t OFFSET = 1 << 20; // 2^20 (handles ±1M chunks)
-        return mortonEncode(xCoord + OFFSET, zCoord + OFFSET);
+        return morton::encode(xCoord + ID_OFFSET, zCoord + ID_OFFSET);
+    }
+
+    // Coordinates of the chunk containing world position
+    static glm::ivec2 getChunkCoords(const glm::ivec3& pos) {
+        return {floorDiv(pos.x, WIDTH), floorDiv(pos.z, DEPTH)};
     }
 
     const ChunkData& getBlocks() const { return data; }
@@ -69,4 +75,10 @@ public:
     const AABB& getChunkBoundingBox() const {
         return box;
     }
+
+    // narrows the box to the blocks that are actually meshed
+    void setHeightRange(const float minY, const float maxY) {
+        box.min.y = minY;
+        box.max.y = maxY;
+    }
 };
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <functional>
 #include <iostream>
 
 #include <glm/glm.hpp>
 
-#include "BlockType.h"
+#include "BlockRegistry.hpp"
+#include "SectionVisibility.hpp"
 
 class ChunkData {
 public:
@@ -13,22 +16,95 @@ public:
         return pos.x + pos.y * WIDTH * DEPTH + pos.z * WIDTH;
     }
 
+    static glm::ivec3 getPos(const size_t index) {
+        return {
+            static_cast<int>(index % WIDTH),
+            static_cast<int>(index / (WIDTH * DEPTH)),
+            static_cast<int>(index / WIDTH % DEPTH)
+        };
+    }
+
 
     static constexpr int WIDTH = 32;
     static constexpr int HEIGHT = 256;
     static constexpr int DEPTH = 32;
-
+    // sections (sub chunks) are meshed and drawn separately
+    static constexpr int SUB_HEIGHT = WIDTH;
+    static constexpr int SUB_COUNT = HEIGHT / SUB_HEIGHT;
+    static constexpr uint8_t ALL_SECTIONS = (1 << SUB_COUNT) - 1;
+    static_assert(SUB_COUNT <= 8, "dirty sections must fit into uint8_t");
+    static_assert(WIDTH == SectionVisibility::SIZE && SUB_HEIGHT == SectionVisibility::SIZE &&
+                  DEPTH == SectionVisibility::SIZE, "sections must be cubes");
+
+    // empty once dropped from a chunk drawn only from its LOD pyramid, see World::dropBlocks
     std::vector<BlockType> blocks;
+    // blocks were changed by World edits, they differ from what the generator makes and are never dropped
+    bool edited = false;
+
+    // bit per section whose mesh no longer matches its blocks
+    uint8_t dirtySections = 0;
+    // layers from the bottom made of opaque blocks only, updated when meshed
+    int solidHeight = 0;
+    // faces connected through every section, updated when meshed
+    std::array<SectionVisibility, SUB_COUNT> visibility{};
 
     ChunkData() : blocks(WIDTH * HEIGHT * DEPTH, BlockType::AIR) {}
 
     void changeBlock(const glm::ivec3& pos, BlockType data) {
         blocks.at(getIndex(pos)) = data;
+        markDirty(pos.y);
         // blocks[getIndex(pos)] = data;
     }
 
     void deleteBlock(const glm::ivec3& pos) {
         blocks[getIndex(pos)] = BlockType::AIR;
+        markDirty(pos.y);
+    }
+
+    // Section containing layer y, and section next to it if y is on its
+    // border (faces there depend on both)
+    static uint8_t sectionMask(const int y) {
+        const int section = y / SUB_HEIGHT;
+        uint8_t mask = 1 << section;
+        if (y % SUB_HEIGHT == 0 && section > 0)
+            mask |= 1 << (section - 1);
+        if (y % SUB_HEIGHT == SUB_HEIGHT - 1 && section < SUB_COUNT - 1)
+            mask |= 1 << (section + 1);
+        return mask;
+    }
+
+    bool hasBlocks() const { return !blocks.empty(); }
+
+    void markDirty(const int y) { dirtySections |= sectionMask(y); }
+
+    void clearDirty() { dirtySections = 0; }
+
+    void updateSolidHeight() {
+        constexpr size_t layer = WIDTH * DEPTH;
+        solidHeight = 0;
+        while (solidHeight < HEIGHT &&
+               std::all_of(blocks.begin() + solidHeight * layer,
+                           blocks.begin() + (solidHeight + 1) * layer, isOpaque))
+            solidHeight++;
+    }
+
+    // layers up to the highest non-air block
+    int getTopHeight() const {
+        constexpr size_t layer = WIDTH * DEPTH;
+        for (int y = HEIGHT - 1; y >= 0; y--) {
+            if (std::any_of(blocks.begin() + y * layer, blocks.begin() + (y + 1) * layer,
+                            [](const BlockType type) { return type != BlockType::AIR; }))
+                return y + 1;
+        }
+        return 0;
+    }
+
+    void updateVisibility(const uint8_t sections) {
+        for (int section = 0; section < SUB_COUNT; section++) {
+            if (sections & 1 << section)
+                visibility[section] = SectionVisibility::compute(
+                    blocks.data() + section * SectionVisibility::VOLUME);
+        }
     }
 
     static void deleteBlock(std::vector<BlockType>::iterator it) {
@@ -63,6 +139,7 @@ public:
             auto value = *it;
             if (pred(value)) {
                 deleteBlock(it);
+                dirtySections = ALL_SECTIONS;
             }
             else {
                 ++it;
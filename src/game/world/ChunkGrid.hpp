@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "ChunkMap.hpp"
+
+// Square window of chunk slots that slides with the camera.
+// Chunk (x, z) is stored in cell (x mod size, z mod size), so moving the window only touches rows and columns
+// entering or leaving it, whatever number of chunks is loaded
+class ChunkGrid {
+public:
+    // Moves window to [origin, origin + size) in chunk coordinates.
+    // onLeave(x, z, slot) is called for every cell leaving the window, slot is ChunkMap::NO_SLOT for empty cells
+    template <typename OnLeave>
+    void update(const glm::ivec2& newOrigin, int newSize, OnLeave onLeave) {
+        if (newSize != size) {
+            // view distance changed, rebuild keeping chunks which stay inside
+            ChunkGrid next;
+            next.size = newSize;
+            next.origin = newOrigin;
+            next.cells.assign(static_cast<size_t>(newSize) * newSize, ChunkMap::NO_SLOT);
+            for (int z = origin.y; z < origin.y + size; z++) {
+                for (int x = origin.x; x < origin.x + size; x++) {
+                    if (next.contains(x, z)) next.at(x, z) = at(x, z);
+                    else leave(x, z, onLeave);
+                }
+            }
+            *this = std::move(next);
+            return;
+        }
+
+        const glm::ivec2 shift = newOrigin - origin;
+        if (shift.x == 0 && shift.y == 0) return;
+
+        if (std::abs(shift.x) >= size || std::abs(shift.y) >= size) {
+            // teleported, whole window leaves
+            for (int z = origin.y; z < origin.y + size; z++)
+                for (int x = origin.x; x < origin.x + size; x++) leave(x, z, onLeave);
+            origin = newOrigin;
+            return;
+        }
+
+        // columns leaving along x
+        const int xLeaveMin = shift.x > 0 ? origin.x : origin.x + size + shift.x;
+        const int xLeaveMax = shift.x > 0 ? origin.x + shift.x : origin.x + size;
+        for (int x = xLeaveMin; x < xLeaveMax; x++)
+            for (int z = origin.y; z < origin.y + size; z++) leave(x, z, onLeave);
+
+        // rows leaving along z, except cells already handled by columns
+        const int xStayMin = std::max(origin.x, newOrigin.x);
+        const int xStayMax = std::min(origin.x, newOrigin.x) + size;
+        const int zLeaveMin = shift.y > 0 ? origin.y : origin.y + size + shift.y;
+        const int zLeaveMax = shift.y > 0 ? origin.y + shift.y : origin.y + size;
+        for (int z = zLeaveMin; z < zLeaveMax; z++)
+            for (int x = xStayMin; x < xStayMax; x++) leave(x, z, onLeave);
+
+        // cells that left are reused by entering chunks, they are already empty
+        origin = newOrigin;
+    }
+
+    bool contains(int x, int z) const {
+        return x >= origin.x && x < origin.x + size && z >= origin.y && z < origin.y + size;
+    }
+
+    // Slot of chunk inside the window
+    uint32_t& at(int x, int z) { return cells[index(x, z)]; }
+    uint32_t at(int x, int z) const { return cells[index(x, z)]; }
+
+    const glm::ivec2& getOrigin() const { return origin; }
+    int getSize() const { return size; }
+
+private:
+    int size = 0;
+    glm::ivec2 origin{0, 0};
+    std::vector<uint32_t> cells;
+
+    int wrap(int v) const {
+        const int r = v % size;
+        return r < 0 ? r + size : r;
+    }
+
+    size_t index(int x, int z) const { return wrap(x) + static_cast<size_t>(wrap(z)) * size; }
+
+    template <typename OnLeave>
+    void leave(int x, int z, OnLeave& onLeave) {
+        uint32_t& slot = at(x, z);
+        onLeave(x, z, slot);
+        slot = ChunkMap::NO_SLOT;
+    }
+};
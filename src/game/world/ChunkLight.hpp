@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "ChunkData.hpp"
+
+enum class LightChannel : uint8_t { SKY, BLOCK };
+
+// Sky and block light of a chunk, 4 bits each per block (sky in the high nibble).
+// Sections are stored separately and stay unallocated while all their blocks have the same light,
+// which is the usual case for open sky above terrain and unlit rock below it
+class ChunkLight {
+public:
+    static constexpr uint8_t MAX_LIGHT = 15;
+    static constexpr uint8_t FULL_SKY = MAX_LIGHT << 4;
+    static constexpr int SECTION_VOLUME = ChunkData::WIDTH * ChunkData::SUB_HEIGHT * ChunkData::DEPTH;
+
+    // both channels packed
+    uint8_t get(const glm::ivec3& pos) const {
+        const int section = pos.y / ChunkData::SUB_HEIGHT;
+        if (sections[section].empty()) return uniform[section];
+        return sections[section][index(pos)];
+    }
+
+    uint8_t get(const glm::ivec3& pos, const LightChannel channel) const {
+        return get(pos) >> shift(channel) & MAX_LIGHT;
+    }
+
+    // Returns true if light changed
+    bool set(const glm::ivec3& pos, const LightChannel channel, const uint8_t level) {
+        const uint8_t old = get(pos);
+        const uint8_t value = (old & ~(MAX_LIGHT << shift(channel))) | level << shift(channel);
+        if (value == old) return false;
+
+        auto& section = sections[pos.y / ChunkData::SUB_HEIGHT];
+        if (section.empty()) section.assign(SECTION_VOLUME, uniform[pos.y / ChunkData::SUB_HEIGHT]);
+        section[index(pos)] = value;
+        return true;
+    }
+
+    // Sets whole section to one packed value and frees its storage
+    void fillSection(const int section, const uint8_t value) {
+        sections[section] = {};
+        uniform[section] = value;
+    }
+
+    size_t getMemory() const {
+        size_t bytes = 0;
+        for (const auto& section : sections) bytes += section.capacity();
+        return bytes;
+    }
+
+private:
+    std::array<std::vector<uint8_t>, ChunkData::SUB_COUNT> sections;
+    // value of every block in unallocated section
+    std::array<uint8_t, ChunkData::SUB_COUNT> uniform{};
+
+    static int shift(const LightChannel channel) { return channel == LightChannel::SKY ? 4 : 0; }
+
+    static size_t index(const glm::ivec3& pos) {
+        return ChunkData::getIndex({pos.x, pos.y % ChunkData::SUB_HEIGHT, pos.z});
+    }
+};
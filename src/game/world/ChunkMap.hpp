@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+
+#include "Chunk.h"
+
+// Flat open addressing map of loaded chunks.
+// Chunks are stored in slots; slot index is stable while chunk is loaded, so per-chunk data of other systems
+// (mesh allocations, buffer views, LODs) lives in plain arrays indexed by the same slot instead of own hash maps
+class ChunkMap {
+public:
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    ChunkMap() : buckets(INITIAL_BUCKETS, Bucket{EMPTY, NO_SLOT}) {}
+
+    uint32_t findSlot(int x, int z) const {
+        const uint64_t key = Chunk::getId(x, z);
+        for (size_t i = key & mask();; i = (i + 1) & mask()) {
+            const Bucket& bucket = buckets[i];
+            if (bucket.key == key) return bucket.slot;
+            if (bucket.key == EMPTY) return NO_SLOT;
+        }
+    }
+
+    // Returns slot of the chunk, creating empty chunk if it is not loaded
+    uint32_t emplace(int x, int z) {
+        if ((count + 1) * 2 > buckets.size()) rehash(buckets.size() * 2);
+
+        const uint64_t key = Chunk::getId(x, z);
+        size_t i = key & mask();
+        for (; buckets[i].key != EMPTY; i = (i + 1) & mask()) {
+            if (buckets[i].key == key) return buckets[i].slot;
+        }
+
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+            slots[slot].emplace(glm::ivec2{x, z});
+        } else {
+            slot = slots.size();
+            slots.emplace_back(std::in_place, glm::ivec2{x, z});
+        }
+
+        buckets[i] = {key, slot};
+        count++;
+        return slot;
+    }
+
+    void erase(uint32_t slot) {
+        if (!contains(slot)) return;
+
+        const uint64_t key = slots[slot]->getId();
+        size_t i = key & mask();
+        while (buckets[i].key != key) i = (i + 1) & mask();
+
+        // backward shift deletion, keeps probe sequences intact without tombstones
+        for (size_t j = (i + 1) & mask(); buckets[j].key != EMPTY; j = (j + 1) & mask()) {
+            const size_t home = buckets[j].key & mask();
+            if (((j - home) & mask()) >= ((j - i) & mask())) {
+                buckets[i] = buckets[j];
+                i = j;
+            }
+        }
+        buckets[i].key = EMPTY;
+
+        slots[slot].reset();
+        freeSlots.push_back(slot);
+        count--;
+    }
+
+    bool contains(uint32_t slot) const { return slot < slots.size() && slots[slot].has_value(); }
+
+    Chunk& operator[](uint32_t slot) { return *slots[slot]; }
+    const Chunk& operator[](uint32_t slot) const { return *slots[slot]; }
+
+    // Upper bound of used slot indices, size for slot-indexed arrays
+    uint32_t slotCount() const { return slots.size(); }
+    size_t size() const { return count; }
+
+private:
+    struct Bucket {
+        uint64_t key;
+        uint32_t slot;
+    };
+
+    static constexpr uint64_t EMPTY = UINT64_MAX;
+    static constexpr size_t INITIAL_BUCKETS = 1024;
+
+    // Morton keys of a compact area are consecutive numbers, so low bits alone are used as hash:
+    // chunks around the camera land in distinct, neighbouring buckets
+    std::vector<Bucket> buckets;
+    // deque keeps references to chunks valid while new chunks are generated
+    std::deque<std::optional<Chunk>> slots;
+    std::vector<uint32_t> freeSlots;
+    size_t count = 0;
+
+    size_t mask() const { return buckets.size() - 1; }
+
+    void rehash(size_t newSize) {
+        std::vector<Bucket> old(newSize, Bucket{EMPTY, NO_SLOT});
+        old.swap(buckets);
+        for (const Bucket& bucket : old) {
+            if (bucket.key == EMPTY) continue;
+            size_t i = bucket.key & mask();
+            while (buckets[i].key != EMPTY) i = (i + 1) & mask();
+            buckets[i] = bucket;
+        }
+    }
+};
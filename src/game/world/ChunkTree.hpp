@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+#include "Chunk.h"
+#include "ChunkMap.hpp"
+
+// Quadtree over loaded chunk columns.
+// Node of level l covers 2^l x 2^l columns, its key is Morton code of the column (Chunk::getId) shifted
+// right by 2l, so parents and children are found by shifting keys. Nodes keep the highest non-air block
+// below them, which makes their boxes tight enough to reject whole regions in queries
+class ChunkTree {
+public:
+    // top nodes cover 64x64 columns
+    static constexpr int LEVELS = 6;
+
+    // Adds column or updates its height (blocks up to the highest non-air one)
+    void insert(const glm::ivec2& coords, uint32_t slot, int height) {
+        const uint64_t key = Chunk::getId(coords.x, coords.y);
+        auto [leaf, inserted] = nodes[0].try_emplace(key);
+        leaf->second = {1, static_cast<uint16_t>(height), slot};
+        update(key, inserted ? 1 : 0);
+    }
+
+    void erase(const glm::ivec2& coords) {
+        const uint64_t key = Chunk::getId(coords.x, coords.y);
+        if (nodes[0].erase(key)) update(key, -1);
+    }
+
+    // height of the column, 0 when not in the tree
+    int getHeight(const glm::ivec2& coords) const {
+        const auto it = nodes[0].find(Chunk::getId(coords.x, coords.y));
+        return it == nodes[0].end() ? 0 : it->second.height;
+    }
+
+    size_t size() const { return nodes[0].size(); }
+
+    // Calls test(box) for nodes from the top. Subtrees of OUTSIDE nodes are skipped, subtrees of INSIDE
+    // nodes are visited without further tests. visit(coords, slot, height, containment) gets every
+    // column that is left, with containment of its own box
+    template <typename Test, typename Visit>
+    void query(Test&& test, Visit&& visit) const {
+        for (const auto& [key, node] : nodes[LEVELS]) queryNode(LEVELS, key, node, test, visit, false);
+    }
+
+private:
+    struct Node {
+        uint32_t count = 0; // columns below
+        uint16_t height = 0;
+        uint32_t slot = ChunkMap::NO_SLOT; // columns only
+    };
+
+    std::array<std::unordered_map<uint64_t, Node>, LEVELS + 1> nodes;
+
+    // Refreshes ancestors of column after it was added, changed or removed
+    void update(const uint64_t key, const int countChange) {
+        for (int level = 1; level <= LEVELS; level++) {
+            const uint64_t parentKey = key >> 2 * level;
+            Node& parent = nodes[level][parentKey];
+            parent.count += countChange;
+            if (parent.count == 0) {
+                nodes[level].erase(parentKey);
+                continue;
+            }
+            parent.height = 0;
+            for (uint64_t child = 0; child < 4; child++) {
+                const auto it = nodes[level - 1].find(parentKey << 2 | child);
+                if (it != nodes[level - 1].end()) parent.height = std::max(parent.height, it->second.height);
+            }
+        }
+    }
+
+    static AABB nodeBox(const int level, const uint64_t key, const int height) {
+        uint32_t x, z;
+        morton::decode(key << 2 * level, x, z);
+        const glm::vec3 min(
+            (static_cast<int>(x) - static_cast<int>(Chunk::ID_OFFSET)) * Chunk::WIDTH, 0,
+            (static_cast<int>(z) - static_cast<int>(Chunk::ID_OFFSET)) * Chunk::DEPTH);
+        return {min, min + glm::vec3(Chunk::WIDTH << level, height, Chunk::DEPTH << level)};
+    }
+
+    template <typename Test, typename Visit>
+    void queryNode(const int level, const uint64_t key, const Node& node, Test& test, Visit& visit,
+                   const bool inside) const {
+        const AABB box = nodeBox(level, key, node.height);
+        Containment containment = Containment::INSIDE;
+        if (!inside) {
+            containment = test(box);
+            if (containment == Containment::OUTSIDE) return;
+        }
+
+        if (level == 0) {
+            const glm::ivec2 coords(static_cast<int>(box.min.x) / Chunk::WIDTH,
+                                    static_cast<int>(box.min.z) / Chunk::DEPTH);
+            visit(coords, node.slot, static_cast<int>(node.height), containment);
+            return;
+        }
+        for (uint64_t child = 0; child < 4; child++) {
+            const auto it = nodes[level - 1].find(key << 2 | child);
+            if (it != nodes[level - 1].end())
+                queryNode(level - 1, it->first, it->second, test, visit, containment == Containment::INSIDE);
+        }
+    }
+};
@@ -0,0 +1,351 @@
+#include "LightEngine.hpp"
+
+#include <algorithm>
+
+#include "BlockEditBatch.hpp"
+#include "EFacing.h"
+#include "World.h"
+#include "utils/ParallelFor.hpp"
+
+namespace {
+    // indexed by Facing
+    constexpr glm::ivec3 DIRECTIONS[6] = {
+        {-1, 0, 0}, {1, 0, 0}, {0, 0, -1}, {0, 0, 1}, {0, 1, 0}, {0, -1, 0}
+    };
+
+    // chunk offset of local position, -1, 0 or 1 on x and z
+    glm::ivec2 chunkOffset(const glm::ivec3& pos) {
+        return {
+            pos.x < 0 ? -1 : pos.x >= Chunk::WIDTH ? 1 : 0,
+            pos.z < 0 ? -1 : pos.z >= Chunk::DEPTH ? 1 : 0
+        };
+    }
+
+    bool isInside(const glm::ivec3& pos) {
+        return pos.x >= 0 && pos.x < Chunk::WIDTH && pos.z >= 0 && pos.z < Chunk::DEPTH;
+    }
+
+    // light spreads only through chunks whose blocks are in memory
+    bool hasBlocks(const Chunk& chunk) {
+        return chunk.state != ChunkState::QUEUED && chunk.data.hasBlocks();
+    }
+}
+
+void LightEngine::reserveSlots(const size_t count) {
+    while (work.size() < count) work.push_back(std::make_unique<ChunkWork>());
+}
+
+void LightEngine::unload(const uint32_t slot) {
+    if (slot >= work.size()) return;
+    std::lock_guard lock(work[slot]->mutex);
+    work[slot]->inbox.clear();
+    work[slot]->edges = {};
+}
+
+void LightEngine::post(const uint32_t slot, const std::span<const Item> items) {
+    if (items.empty()) return;
+    ChunkWork& chunkWork = *work[slot];
+    bool first;
+    {
+        std::lock_guard lock(chunkWork.mutex);
+        first = chunkWork.inbox.empty();
+        chunkWork.inbox.insert(chunkWork.inbox.end(), items.begin(), items.end());
+    }
+    if (first) {
+        std::lock_guard lock(pendingMutex);
+        pending.push_back(slot);
+    }
+}
+
+void LightEngine::post(World& world, const glm::ivec2 coords, glm::ivec3 pos, Item item) {
+    if (pos.y < 0 || pos.y >= Chunk::HEIGHT) return;
+    const glm::ivec2 offset = chunkOffset(pos);
+    const uint32_t slot = world.chunks.findSlot(coords.x + offset.x, coords.y + offset.y);
+    // chunk which is not generated yet pulls light from its neighbours in initChunk, chunk with
+    // dropped blocks is far away and keeps the light it had
+    if (slot == ChunkMap::NO_SLOT || !hasBlocks(world.chunks[slot])) return;
+
+    pos.x -= offset.x * Chunk::WIDTH;
+    pos.z -= offset.y * Chunk::DEPTH;
+    item.index = ChunkData::getIndex(pos);
+    post(slot, item);
+}
+
+void LightEngine::initChunk(World& world, const uint32_t slot) {
+    reserveSlots(world.chunks.slotCount());
+    Chunk& chunk = world.chunks[slot];
+    const ChunkData& data = chunk.data;
+    ChunkLight& light = chunk.light;
+    const glm::ivec2 coords{chunk.xCoord, chunk.zCoord};
+
+    // highest opaque block of every column, -1 for empty columns
+    std::array<int, Chunk::WIDTH * Chunk::DEPTH> tops;
+    int maxTop = -1;
+    for (int z = 0; z < Chunk::DEPTH; z++) {
+        for (int x = 0; x < Chunk::WIDTH; x++) {
+            int y = Chunk::HEIGHT - 1;
+            while (y >= 0 && !isOpaque(data.getBlock({x, y, z}))) y--;
+            tops[x + z * Chunk::WIDTH] = y;
+            maxTop = std::max(maxTop, y);
+        }
+    }
+
+    // sections above every column are open sky and need no storage
+    const int openSection = maxTop / Chunk::SUB_HEIGHT + 1;
+    for (int section = openSection; section < Chunk::SUB_COUNT; section++)
+        light.fillSection(section, ChunkLight::FULL_SKY);
+
+    // sky goes straight down to the first opaque block
+    for (int z = 0; z < Chunk::DEPTH; z++)
+        for (int x = 0; x < Chunk::WIDTH; x++)
+            for (int y = tops[x + z * Chunk::WIDTH] + 1; y < openSection * Chunk::SUB_HEIGHT; y++)
+                light.set({x, y, z}, LightChannel::SKY, ChunkLight::MAX_LIGHT);
+
+    std::vector<Item> items;
+
+    // and sideways from columns into overhangs of higher columns next to them
+    for (int z = 0; z < Chunk::DEPTH; z++) {
+        for (int x = 0; x < Chunk::WIDTH; x++) {
+            const int top = tops[x + z * Chunk::WIDTH];
+            int neighbourTop = top;
+            for (int d = 0; d < 4; d++) {
+                const glm::ivec3 n = glm::ivec3{x, 0, z} + DIRECTIONS[d];
+                if (isInside(n)) neighbourTop = std::max(neighbourTop, tops[n.x + n.z * Chunk::WIDTH]);
+            }
+            for (int y = top + 1; y <= neighbourTop; y++)
+                items.push_back({static_cast<uint32_t>(ChunkData::getIndex({x, y, z})), 0, LightChannel::SKY, Op::RELIGHT});
+        }
+    }
+
+    for (uint32_t i = 0; i < data.blocks.size(); i++) {
+        if (const uint8_t emission = getLightEmission(data.blocks[i]))
+            items.push_back({i, emission, LightChannel::BLOCK, Op::SET});
+    }
+
+    // light crossing borders with loaded neighbours, whichever side is brighter spreads again.
+    // Runs on the main thread, so reading neighbour light is safe here
+    for (int d = 0; d < 4; d++) {
+        const glm::ivec3 direction = DIRECTIONS[d];
+        const uint32_t neighbourSlot = world.chunks.findSlot(coords.x + direction.x, coords.y + direction.z);
+        if (neighbourSlot == ChunkMap::NO_SLOT || !hasBlocks(world.chunks[neighbourSlot])) continue;
+        const Chunk& neighbour = world.chunks[neighbourSlot];
+
+        for (int i = 0; i < Chunk::WIDTH; i++) {
+            // border block of this chunk and block next to it in the neighbour
+            glm::ivec3 own{i, 0, i}, other{i, 0, i};
+            if (direction.x) {
+                own.x = direction.x < 0 ? 0 : Chunk::WIDTH - 1;
+                other.x = Chunk::WIDTH - 1 - own.x;
+            }
+            else {
+                own.z = direction.z < 0 ? 0 : Chunk::DEPTH - 1;
+                other.z = Chunk::DEPTH - 1 - own.z;
+            }
+
+            for (int y = 0; y < Chunk::HEIGHT; y++) {
+                own.y = other.y = y;
+                for (const auto channel : {LightChannel::SKY, LightChannel::BLOCK}) {
+                    const int ownLevel = light.get(own, channel);
+                    const int otherLevel = neighbour.light.get(other, channel);
+                    if (otherLevel - 1 > ownLevel && !isOpaque(data.getBlock(own)))
+                        post(neighbourSlot, {static_cast<uint32_t>(ChunkData::getIndex(other)), 0, channel, Op::RELIGHT});
+                    else if (ownLevel - 1 > otherLevel && !isOpaque(neighbour.data.getBlock(other)))
+                        items.push_back({static_cast<uint32_t>(ChunkData::getIndex(own)), 0, channel, Op::RELIGHT});
+                }
+            }
+        }
+    }
+    post(slot, items);
+}
+
+void LightEngine::onBlocksChanged(World& world, const uint32_t slot, const std::span<const BlockChange> changes) {
+    const Chunk& chunk = world.chunks[slot];
+    // light of chunk which is not generated yet is set up from scratch
+    if (chunk.state == ChunkState::QUEUED) return;
+
+    std::vector<Item> items;
+    for (const auto& [index, old, type] : changes) {
+        if (old == type) continue;
+        if (isOpaque(type) && !isOpaque(old)) items.push_back({index, 0, LightChannel::SKY, Op::SET});
+        if (isOpaque(type) != isOpaque(old) || getLightEmission(type) != getLightEmission(old))
+            items.push_back({index, getLightEmission(type), LightChannel::BLOCK, Op::SET});
+
+        // opened block is lit again from around
+        if (!isOpaque(old) || isOpaque(type)) continue;
+        const glm::ivec3 pos = ChunkData::getPos(index);
+        for (const auto& direction : DIRECTIONS) {
+            const glm::ivec3 n = pos + direction;
+            if (n.y < 0 || n.y >= Chunk::HEIGHT) continue;
+            for (const auto channel : {LightChannel::SKY, LightChannel::BLOCK}) {
+                if (isInside(n))
+                    items.push_back({static_cast<uint32_t>(ChunkData::getIndex(n)), 0, channel, Op::RELIGHT});
+                else post(world, {chunk.xCoord, chunk.zCoord}, n, {0, 0, channel, Op::RELIGHT});
+            }
+        }
+    }
+    post(slot, items);
+}
+
+void LightEngine::update(World& world) {
+    reserveSlots(world.chunks.slotCount());
+
+    for (int round = 0; round < MAX_ROUNDS && !pending.empty(); round++) {
+        std::vector<uint32_t> slots;
+        {
+            std::lock_guard lock(pendingMutex);
+            slots.swap(pending);
+        }
+        // unloaded and reloaded chunk may be listed twice
+        std::ranges::sort(slots);
+        slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+        parallelFor(slots.size(), [&](const size_t i) { relight(world, slots[i]); });
+
+        // faces of neighbours sample light on chunk edges
+        for (const uint32_t slot : slots) {
+            if (!world.chunks.contains(slot)) continue;
+            const Chunk& chunk = world.chunks[slot];
+            auto& edges = work[slot]->edges;
+            for (int edge = 0; edge < 4; edge++) {
+                if (!edges[edge]) continue;
+                const glm::ivec3 direction = DIRECTIONS[edge];
+                const uint32_t neighbour = world.chunks.findSlot(chunk.xCoord + direction.x,
+                                                                 chunk.zCoord + direction.z);
+                if (neighbour != ChunkMap::NO_SLOT) world.chunks[neighbour].data.dirtySections |= edges[edge];
+            }
+            edges = {};
+        }
+    }
+}
+
+void LightEngine::relight(World& world, const uint32_t slot) {
+    std::vector<Item> items;
+    {
+        std::lock_guard lock(work[slot]->mutex);
+        items.swap(work[slot]->inbox);
+    }
+    if (!world.chunks.contains(slot) || !hasBlocks(world.chunks[slot])) return;
+
+    relightChannel(world, slot, LightChannel::SKY, items);
+    relightChannel(world, slot, LightChannel::BLOCK, items);
+}
+
+void LightEngine::relightChannel(World& world, const uint32_t slot, const LightChannel channel,
+                                 std::vector<Item>& items) {
+    struct Node {
+        glm::ivec3 pos;
+        uint8_t level;
+    };
+    // reused by every chunk the thread relights
+    thread_local std::vector<Node> removals;
+    thread_local std::vector<Node> emitters;
+    thread_local std::vector<glm::ivec3> adds;
+    removals.clear();
+    emitters.clear();
+    adds.clear();
+
+    Chunk& chunk = world.chunks[slot];
+    ChunkData& data = chunk.data;
+    ChunkLight& light = chunk.light;
+    ChunkWork& chunkWork = *work[slot];
+    const glm::ivec2 coords{chunk.xCoord, chunk.zCoord};
+
+    const auto setLight = [&](const glm::ivec3& pos, const uint8_t level) {
+        if (!light.set(pos, channel, level)) return;
+        const uint8_t sections = ChunkData::sectionMask(pos.y);
+        data.dirtySections |= sections;
+        if (pos.x == 0) chunkWork.edges[BlockEditBatch::EDGE_X_MIN] |= sections;
+        if (pos.x == Chunk::WIDTH - 1) chunkWork.edges[BlockEditBatch::EDGE_X_MAX] |= sections;
+        if (pos.z == 0) chunkWork.edges[BlockEditBatch::EDGE_Z_MIN] |= sections;
+        if (pos.z == Chunk::DEPTH - 1) chunkWork.edges[BlockEditBatch::EDGE_Z_MAX] |= sections;
+    };
+
+    for (const Item& item : items) {
+        if (item.channel != channel) continue;
+        const glm::ivec3 pos = ChunkData::getPos(item.index);
+        const uint8_t current = light.get(pos, channel);
+
+        switch (item.op) {
+            case Op::ADD:
+                if (current < item.level && !isOpaque(data.getBlock(pos))) {
+                    setLight(pos, item.level);
+                    adds.push_back(pos);
+                }
+                break;
+            case Op::REMOVE:
+                if (current && current < item.level) {
+                    setLight(pos, 0);
+                    removals.push_back({pos, current});
+                }
+                else if (current) adds.push_back(pos);
+                break;
+            case Op::RELIGHT:
+                if (current) adds.push_back(pos);
+                break;
+            case Op::SET:
+                if (item.level < current) {
+                    // darker block has to clear light it gave before
+                    setLight(pos, 0);
+                    removals.push_back({pos, current});
+                    if (item.level) emitters.push_back({pos, item.level});
+                }
+                else if (item.level > current) {
+                    setLight(pos, item.level);
+                    adds.push_back(pos);
+                }
+                break;
+        }
+    }
+
+    // blocks lit by removed light go dark, brighter ones spread their light back afterwards
+    for (size_t head = 0; head < removals.size(); head++) {
+        const auto [pos, level] = removals[head];
+        for (int d = 0; d < 6; d++) {
+            const glm::ivec3 n = pos + DIRECTIONS[d];
+            if (n.y < 0 || n.y >= Chunk::HEIGHT) continue;
+            if (!isInside(n)) {
+                post(world, coords, n, {0, level, channel, Op::REMOVE});
+                continue;
+            }
+
+            const uint8_t current = light.get(n, channel);
+            if (!current) continue;
+            // full skylight below full skylight came straight from above
+            const bool skyColumn = channel == LightChannel::SKY && d == DOWN && level == ChunkLight::MAX_LIGHT;
+            if (current < level || skyColumn) {
+                setLight(n, 0);
+                removals.push_back({n, current});
+                if (channel == LightChannel::BLOCK) {
+                    if (const uint8_t emission = getLightEmission(data.getBlock(n))) emitters.push_back({n, emission});
+                }
+            }
+            else adds.push_back(n);
+        }
+    }
+
+    for (const auto& [pos, level] : emitters) {
+        if (light.get(pos, channel) >= level) continue;
+        setLight(pos, level);
+        adds.push_back(pos);
+    }
+
+    for (size_t head = 0; head < adds.size(); head++) {
+        const glm::ivec3 pos = adds[head];
+        const uint8_t level = light.get(pos, channel);
+        for (int d = 0; d < 6; d++) {
+            const bool skyColumn = channel == LightChannel::SKY && d == DOWN && level == ChunkLight::MAX_LIGHT;
+            const uint8_t target = skyColumn ? level : level - 1;
+            if (level == 0 || target == 0) continue;
+
+            const glm::ivec3 n = pos + DIRECTIONS[d];
+            if (n.y < 0 || n.y >= Chunk::HEIGHT) continue;
+            if (!isInside(n)) {
+                post(world, coords, n, {0, target, channel, Op::ADD});
+                continue;
+            }
+            if (isOpaque(data.getBlock(n)) || light.get(n, channel) >= target) continue;
+            setLight(n, target);
+            adds.push_back(n);
+        }
+    }
+}
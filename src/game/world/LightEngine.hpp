@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "ChunkLight.hpp"
+
+class World;
+
+// Flood fill sky and block light.
+// Every chunk has its own inbox of light work. Relighting a chunk writes light of that chunk only and
+// hands light crossing its border to the neighbour's inbox, so chunks are relit in parallel and only
+// inboxes are locked, never the world. Changed light marks chunk sections dirty for the mesher
+class LightEngine {
+public:
+    // Relight rounds per update, light needs one round for every chunk border it crosses
+    static constexpr int MAX_ROUNDS = 8;
+
+    // Sets up light of freshly generated chunk: sky straight down every column, light spreading
+    // sideways and from emitters is queued
+    void initChunk(World& world, uint32_t slot);
+
+    struct BlockChange {
+        uint32_t index; // ChunkData::getIndex
+        BlockType old;
+        BlockType type;
+    };
+
+    // Queues relight around changed blocks of chunk slot. May be called for different chunks in parallel
+    void onBlocksChanged(World& world, uint32_t slot, std::span<const BlockChange> changes);
+
+    // Propagates queued light
+    void update(World& world);
+
+    // Light work of unloaded chunk is dropped, chunk gets it again from its neighbours in initChunk
+    void unload(uint32_t slot);
+
+    // Inboxes must exist for every slot before chunks are relit in parallel
+    void reserveSlots(size_t count);
+
+    bool hasWork() const { return !pending.empty(); }
+
+private:
+    enum class Op : uint8_t {
+        ADD, // offer light level to the block
+        REMOVE, // light of given level next to the block was removed
+        RELIGHT, // spread current light of the block again
+        SET, // set the block to given level, removing old light around if it was brighter
+    };
+
+    struct Item {
+        uint32_t index; // ChunkData::getIndex
+        uint8_t level;
+        LightChannel channel;
+        Op op;
+    };
+
+    struct ChunkWork {
+        std::mutex mutex;
+        std::vector<Item> inbox;
+        // sections with changed light on chunk edges, neighbour faces there sample it. [BlockEditBatch::Edge]
+        std::array<uint8_t, 4> edges{};
+    };
+
+    std::vector<std::unique_ptr<ChunkWork>> work;
+
+    // chunks with non-empty inbox
+    std::mutex pendingMutex;
+    std::vector<uint32_t> pending;
+
+    // Queues item for block at local pos of chunk at coords, pos may lie in a neighbour chunk
+    void post(World& world, glm::ivec2 coords, glm::ivec3 pos, Item item);
+    void post(uint32_t slot, std::span<const Item> items);
+    void post(uint32_t slot, const Item& item) { post(slot, {&item, 1}); }
+
+    void relight(World& world, uint32_t slot);
+    void relightChannel(World& world, uint32_t slot, LightChannel channel, std::vector<Item>& items);
+};
@@ -1 +1,100 @@
 #include "LowDetailChunk.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // Most common non-air block of a 2x2x2 group, ties go to the upper cells so surface blocks (grass) win.
+    // children[0..3] are the upper layer
+    BlockType vote(const BlockType (&children)[8]) {
+        BlockType best = BlockType::AIR;
+        int bestCount = 0;
+        for (int i = 0; i < 8; i++) {
+            if (children[i] == BlockType::AIR) continue;
+            int count = 0;
+            for (int j = i; j < 8; j++) count += children[j] == children[i];
+            if (count > bestCount) {
+                best = children[i];
+                bestCount = count;
+            }
+        }
+        return best;
+    }
+
+    // Reduces 2 rows of the lower layer (lo0, lo1) and 2 rows of the upper layer (hi0, hi1), `count` children each,
+    // into count / 2 parent cells
+    void reduceRows(const BlockType* lo0, const BlockType* lo1, const BlockType* hi0, const BlockType* hi1,
+                    const int count, BlockType* out) {
+        int x = 0;
+#ifdef __SSE2__
+        // 4 children (2 parents) per iteration: occupancy and uniformity are resolved with SIMD,
+        // only mixed groups fall through to the scalar vote
+        for (; x + 4 <= count; x += 4) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lo0 + x));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lo1 + x));
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hi0 + x));
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hi1 + x));
+
+            __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+            any = _mm_or_si128(any, _mm_shuffle_epi32(any, _MM_SHUFFLE(2, 3, 0, 1)));
+
+            __m128i same = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi32(a, b), _mm_cmpeq_epi32(a, c)),
+                                         _mm_cmpeq_epi32(a, d));
+            same = _mm_and_si128(same, _mm_cmpeq_epi32(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(2, 3, 0, 1))));
+            same = _mm_and_si128(same, _mm_shuffle_epi32(same, _MM_SHUFFLE(2, 3, 0, 1)));
+
+            const int empty = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(any, _mm_setzero_si128())));
+            const int uniform = _mm_movemask_ps(_mm_castsi128_ps(same));
+
+            for (int p = 0; p < 2; p++) {
+                const int lane = 2 * p;
+                const int i = x + lane;
+                if (empty & (1 << lane)) out[i / 2] = BlockType::AIR;
+                else if (uniform & (1 << lane)) out[i / 2] = lo0[i];
+                else out[i / 2] = vote({hi0[i], hi0[i + 1], hi1[i], hi1[i + 1], lo0[i], lo0[i + 1], lo1[i], lo1[i + 1]});
+            }
+        }
+#endif
+        for (; x < count; x += 2) {
+            out[x / 2] = vote({hi0[x], hi0[x + 1], hi1[x], hi1[x + 1], lo0[x], lo0[x + 1], lo1[x], lo1[x + 1]});
+        }
+    }
+}
+
+void LowDetailChunk::downsample(const BlockType* src, const int width, const int height, const int depth,
+                                LowDetailChunkData& dst) {
+    const size_t layer = static_cast<size_t>(width) * depth;
+    for (int y = 0; y < dst.height; y++) {
+        for (int z = 0; z < dst.depth; z++) {
+            const BlockType* lo0 = src + 2 * y * layer + 2 * z * width;
+            const BlockType* lo1 = lo0 + width;
+            const BlockType* hi0 = lo0 + layer;
+            const BlockType* hi1 = hi0 + width;
+            reduceRows(lo0, lo1, hi0, hi1, width, dst.data.data() + dst.getID({0, y, z}));
+        }
+    }
+}
+
+std::vector<LowDetailChunk> LowDetailChunk::buildPyramid(const Chunk& chunk) {
+    std::vector<LowDetailChunk> pyramid;
+    pyramid.reserve(LOD_LEVELS);
+
+    const glm::ivec2 coords{chunk.xCoord, chunk.zCoord};
+    const BlockType* src = chunk.getBlocks().blocks.data();
+    int width = Chunk::WIDTH;
+    int height = Chunk::HEIGHT;
+    int depth = Chunk::DEPTH;
+
+    for (int LOD = 1; LOD <= LOD_LEVELS; LOD++) {
+        auto& level = pyramid.emplace_back(LOD, coords);
+        downsample(src, width, height, depth, level.data_);
+
+        src = level.data_.data.data();
+        width = level.data_.width;
+        height = level.data_.height;
+        depth = level.data_.depth;
+    }
+
+    return pyramid;
+}
@@ -3,8 +3,9 @@
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
-#include "BlockType.h"
+#include "BlockRegistry.hpp"
 #include "Chunk.h"
+#include "globals.hpp"
 
 struct LowDetailChunkData {
     const int width;
@@ -13,15 +14,19 @@ struct LowDetailChunkData {
 
     std::vector<BlockType> data;
 
-    short getID(const glm::ivec3& pos) const {
+    size_t getID(const glm::ivec3& pos) const {
         return pos.x + pos.z * width + pos.y * width * depth;
     }
 
+    bool isInside(const glm::ivec3& pos) const {
+        return pos.x >= 0 && pos.x < width && pos.y >= 0 && pos.y < height && pos.z >= 0 && pos.z < depth;
+    }
+
     LowDetailChunkData(int width, int height, int depth) : width(width), height(height), depth(depth),
                                                            data(width * height * depth) {}
 
     bool containsBlock(const glm::ivec3& pos) const {
-        return data[getID(pos)] != BlockType::AIR;
+        return isOpaque(data[getID(pos)]);
     }
 };
 
@@ -30,38 +35,21 @@ class LowDetailChunk {
     int LOD_;
 
 public:
-    explicit LowDetailChunk(int LOD) : data_(Chunk::WIDTH >> LOD, Chunk::HEIGHT >> LOD, Chunk::DEPTH >> LOD),
-                              LOD_(LOD) {}
+    int xCoord; //chunk coordinate
+    int zCoord; //chunk coordinate
 
-    LowDetailChunk(int LOD, Chunk& chunk) : data_(Chunk::WIDTH >> LOD, Chunk::HEIGHT >> LOD, Chunk::DEPTH >> LOD),
-                                            LOD_(LOD) {
-        int step = 1 << LOD;
-        for (int y = 0; y < Chunk::HEIGHT; y += step) {
-            for (int z = 0; z < Chunk::DEPTH; z += step) {
-                for (int x = 0; x < Chunk::WIDTH; x += step) {
-                    bool done = false;
-                    int y0 = 0;
-                    int z0 = 0;
-                    int x0 = 0;
-                    for (; y0 < step; y0++) {
-                        if (done) break;
-                        for (; z0 < step; z0++) {
-                            if (done) break;
-                            for (; x0 < step; x0++) {
-                                if (chunk.data.containsBlock({x + x0, y + y0, z + z0})) {
-                                    done = true;
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                    data_.data[data_.getID({x >> LOD, y >> LOD, z >> LOD})] =
-                        chunk.data.getBlock({x + x0 % step, y + y0 % step, z + z0 % step});
-                }
-            }
-        }
-    }
+    LowDetailChunk(int LOD, glm::ivec2 coords) : data_(Chunk::WIDTH >> LOD, Chunk::HEIGHT >> LOD, Chunk::DEPTH >> LOD),
+                                                 LOD_(LOD), xCoord(coords.x), zCoord(coords.y) {}
 
-    const LowDetailChunkData& getBlocks() { return data_; }
+    // Builds LOD1..LOD_LEVELS in one pass, every level is reduced from the previous one.
+    // Returned vector is indexed by LOD - 1
+    static std::vector<LowDetailChunk> buildPyramid(const Chunk& chunk);
+
+    const LowDetailChunkData& getBlocks() const { return data_; }
     int getLODLevel() const { return LOD_; }
+    size_t getMemory() const { return data_.data.capacity() * sizeof(BlockType); }
+
+private:
+    // Reduces every 2x2x2 cell group of src into one cell of dst
+    static void downsample(const BlockType* src, int width, int height, int depth, LowDetailChunkData& dst);
 };
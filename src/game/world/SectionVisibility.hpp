@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+#include "BlockRegistry.hpp"
+#include "EFacing.h"
+
+// Which faces of a section see each other through non-opaque blocks, bit per pair of the 6 faces.
+// The renderer walks sections from the camera only through connected faces, so caves and rock
+// the camera cannot look into are never drawn
+class SectionVisibility {
+public:
+    static constexpr int SIZE = 32;
+    static constexpr int VOLUME = SIZE * SIZE * SIZE;
+    static constexpr uint16_t NONE = 0;
+    static constexpr uint16_t ALL = (1 << 15) - 1;
+
+    // unknown visibility is open, nothing may be culled by mistake
+    uint16_t bits = ALL;
+
+    bool connected(const Facing a, const Facing b) const {
+        return a == b || bits & pairBit(a, b);
+    }
+
+    void connect(const Facing a, const Facing b) {
+        if (a != b) bits |= pairBit(a, b);
+    }
+
+    // Flood fills non-opaque blocks of a section laid out x, then z, then y (as in ChunkData)
+    static SectionVisibility compute(const BlockType* blocks) {
+        if (std::none_of(blocks, blocks + VOLUME, isOpaque)) return {ALL};
+        if (std::all_of(blocks, blocks + VOLUME, isOpaque)) return {NONE};
+
+        SectionVisibility result{NONE};
+        std::bitset<VOLUME> visited;
+        thread_local std::vector<int> stack;
+
+        for (int start = 0; start < VOLUME; start++) {
+            if (visited[start] || isOpaque(blocks[start])) continue;
+
+            // faces touched by this pocket of air
+            uint8_t faces = 0;
+            stack.push_back(start);
+            visited[start] = true;
+            while (!stack.empty()) {
+                // pocket touching every face connects all of them, the rest changes nothing
+                if (faces == (1 << 6) - 1) {
+                    stack.clear();
+                    return {ALL};
+                }
+                const int i = stack.back();
+                stack.pop_back();
+                const int x = i % SIZE;
+                const int z = i / SIZE % SIZE;
+                const int y = i / (SIZE * SIZE);
+
+                const auto visit = [&](const bool inside, const Facing face, const int next) {
+                    if (!inside) {
+                        faces |= 1 << face;
+                        return;
+                    }
+                    if (visited[next] || isOpaque(blocks[next])) return;
+                    visited[next] = true;
+                    stack.push_back(next);
+                };
+                visit(x > 0, WEST, i - 1);
+                visit(x < SIZE - 1, EAST, i + 1);
+                visit(z > 0, SOUTH, i - SIZE);
+                visit(z < SIZE - 1, NORTH, i + SIZE);
+                visit(y < SIZE - 1, UP, i + SIZE * SIZE);
+                visit(y > 0, DOWN, i - SIZE * SIZE);
+            }
+
+            for (int a = 0; a < 6; a++)
+                for (int b = a + 1; b < 6; b++)
+                    if (faces & 1 << a && faces & 1 << b)
+                        result.connect(static_cast<Facing>(a), static_cast<Facing>(b));
+        }
+        return result;
+    }
+
+private:
+    // index of unordered pair of different faces, 0..14
+    static constexpr uint16_t pairBit(const Facing a, const Facing b) {
+        const int lo = std::min(a, b);
+        const int hi = std::max(a, b);
+        return 1 << (lo * (11 - lo) / 2 + hi - lo - 1);
+    }
+};
@@ -0,0 +1,61 @@
+#include "World.h"
+
+#include "utils/ParallelFor.hpp"
+
+namespace {
+    // smaller batches are not worth starting threads for
+    constexpr size_t PARALLEL_APPLY_EDITS = 16 * 1024;
+}
+
+void World::apply(const BlockEditBatch& batch) {
+    const auto& edited = batch.getChunks();
+    if (edited.empty()) return;
+
+    // chunk map is not thread safe, so chunks are loaded and generated up front
+    std::vector<uint32_t> slots(edited.size());
+    for (size_t i = 0; i < edited.size(); i++) {
+        slots[i] = getSlot(edited[i].coords.x, edited[i].coords.y);
+        // pyramid is rebuilt from new blocks when needed again
+        if (slots[i] < LODs.size()) LODs[slots[i]].clear();
+    }
+
+    light_.reserveSlots(chunks.slotCount());
+
+    std::vector<int> heights(edited.size());
+    const auto applyChunk = [&](const size_t i) {
+        ChunkData& data = chunks[slots[i]].data;
+        std::vector<LightEngine::BlockChange> changes;
+        changes.reserve(edited[i].edits.size());
+        for (const auto& edit : edited[i].edits) {
+            changes.push_back({edit.index, data.blocks[edit.index], edit.type});
+            data.blocks[edit.index] = edit.type;
+        }
+        data.dirtySections |= edited[i].sections;
+        data.edited = true;
+        light_.onBlocksChanged(*this, slots[i], changes);
+        heights[i] = data.getTopHeight();
+    };
+
+    // every chunk is written by one thread only
+    parallelFor(edited.size(), applyChunk, batch.size() < PARALLEL_APPLY_EDITS ? SIZE_MAX : 2);
+
+    revision_++;
+    for (size_t i = 0; i < edited.size(); i++) tree.insert(edited[i].coords, slots[i], heights[i]);
+
+    // neighbours are marked once per chunk edge instead of once per block
+    for (const auto& chunk : edited) {
+        const glm::ivec2 c = chunk.coords;
+        if (chunk.edges[BlockEditBatch::EDGE_X_MIN])
+            markNeighbourDirty(c.x - 1, c.y, chunk.edges[BlockEditBatch::EDGE_X_MIN]);
+        if (chunk.edges[BlockEditBatch::EDGE_X_MAX])
+            markNeighbourDirty(c.x + 1, c.y, chunk.edges[BlockEditBatch::EDGE_X_MAX]);
+        if (chunk.edges[BlockEditBatch::EDGE_Z_MIN])
+            markNeighbourDirty(c.x, c.y - 1, chunk.edges[BlockEditBatch::EDGE_Z_MIN]);
+        if (chunk.edges[BlockEditBatch::EDGE_Z_MAX])
+            markNeighbourDirty(c.x, c.y + 1, chunk.edges[BlockEditBatch::EDGE_Z_MAX]);
+        for (int corner = 0; corner < 4; corner++) {
+            if (chunk.corners[corner])
+                markNeighbourDirty(c.x + (corner & 1 ? 1 : -1), c.y + (corner & 2 ? 1 : -1), chunk.corners[corner]);
+        }
+    }
+}
@@ -1,9 +1,13 @@
 #pragma once
 
-#include <unordered_map>
+#include <vector>
 
+#include "BlockEditBatch.hpp"
 #include "Chunk.h"
+#include "ChunkMap.hpp"
+#include "ChunkTree.hpp"
 #include "globals.hpp"
+#include "LightEngine.hpp"
 #include "LowDetailChunk.hpp"
 #include "worldgen/WorldGenerator.hpp"
 
@@ -12,59 +16,152 @@ public:
     //chunks[z][x], 2*VIEW_DISTANCE chunks in each side
     //Using deque because of O(1) index search, O(1) insertion in each side (like when moving frontwards or backwards)
     // std::deque<std::deque<std::array<Chunk, WORLD_HEIGHT / Chunk::HEIGHT>>> chunks;
-    std::unordered_map<size_t, Chunk> chunks;
+    ChunkMap chunks;
 
-    std::array<std::unordered_map<size_t, LowDetailChunk>, LOD_LEVELS> LODs;
+    // generated columns with their heights, for spatial queries
+    ChunkTree tree;
+
+    // LOD pyramid of every chunk slot, LODs[slot][LOD - 1]. Empty until requested
+    std::vector<std::vector<LowDetailChunk>> LODs;
 
     static constexpr float DAY_DURATION_SEC = 1.0f;
 
-    Chunk* getChunk(int x, int z) {
-        auto it = chunks.find(Chunk::getId(x, z));
-        if (it == chunks.end()) {
-            //cannot find, generate
-            return &generateChunk(x, z);
+    // Slot of the chunk, reserves QUEUED chunk if it is not loaded
+    uint32_t reserveSlot(int x, int z) {
+        return chunks.emplace(x, z);
+    }
+
+    // Slot of the chunk, generates chunk if it is not loaded
+    uint32_t getSlot(int x, int z) {
+        const uint32_t slot = reserveSlot(x, z);
+        generate(slot);
+        return slot;
+    }
+
+    void generate(uint32_t slot) {
+        Chunk& chunk = chunks[slot];
+        if (chunk.state != ChunkState::QUEUED) {
+            // dropped blocks come back the same from the generator, light was kept
+            if (!chunk.data.hasBlocks()) {
+                chunk.data.blocks.assign(Chunk::WIDTH * Chunk::HEIGHT * Chunk::DEPTH, BlockType::AIR);
+                generator_.generateChunk(chunk);
+            }
+            return;
         }
-        return &it->second;
+        generator_.generateChunk(chunk);
+        chunk.state = ChunkState::GENERATED;
+        revision_++;
+        tree.insert({chunk.xCoord, chunk.zCoord}, slot, chunk.data.getTopHeight());
+        light_.initChunk(*this, slot);
+    }
+
+    // Propagates light changed since last update
+    void update() { light_.update(*this); }
+
+    Chunk* getChunk(int x, int z) {
+        return &chunks[getSlot(x, z)];
     }
 
     Chunk const* getChunk(int x, int z) const {
-        auto it = chunks.find(Chunk::getId(x, z));
-        if (it == chunks.end()) {
+        const uint32_t slot = chunks.findSlot(x, z);
+        if (slot == ChunkMap::NO_SLOT || chunks[slot].state == ChunkState::QUEUED) {
             return nullptr;
         }
-        return &it->second;
+        return &chunks[slot];
     }
 
     LowDetailChunk const* getLowDetailChunk(int x, int z, int LOD) const {
-        auto& lowDetailedChunks = LODs[LOD - 1];
-        auto it = lowDetailedChunks.find(Chunk::getId(x, z));
-        if (it == lowDetailedChunks.end()) return nullptr;
-        return &it->second;
+        const uint32_t slot = chunks.findSlot(x, z);
+        if (slot == ChunkMap::NO_SLOT || slot >= LODs.size() || LODs[slot].empty()) return nullptr;
+        return &LODs[slot][LOD - 1];
     }
 
+    // Generates the chunk only when its pyramid has to be built, so a chunk
+    // whose blocks were dropped keeps them dropped
     LowDetailChunk* getLowDetailChunk(int x, int z, int LOD) {
-        auto& lowDetailedChunks = LODs[LOD - 1];
-        auto it = lowDetailedChunks.find(Chunk::getId(x, z));
-        if (it == lowDetailedChunks.end()) {
-            return &generateChunkLOD(x, z, LOD);
+        uint32_t slot = chunks.findSlot(x, z);
+        if (slot == ChunkMap::NO_SLOT || slot >= LODs.size() || LODs[slot].empty()) {
+            slot = getSlot(x, z);
+            if (slot >= LODs.size()) LODs.resize(chunks.slotCount());
+            LODs[slot] = LowDetailChunk::buildPyramid(chunks[slot]);
         }
-        return &it->second;
+        return &LODs[slot][LOD - 1];
     }
 
-private:
-    WorldGenerator generator_;
+    // Bytes held by LOD pyramid of the chunk, 0 if it was not built
+    size_t getLODMemory(uint32_t slot) const {
+        if (slot >= LODs.size()) return 0;
+        size_t bytes = 0;
+        for (const LowDetailChunk& level : LODs[slot]) bytes += level.getMemory();
+        return bytes;
+    }
 
-    Chunk& generateChunk(int x, int z) {
-        return generator_.generateChunk(x, z, chunks);
+    // Frees full detail blocks of a chunk drawn from its LOD pyramid, so LOD rings cost only the
+    // pyramid. Edited blocks are kept, the rest are generated again by getSlot when needed
+    void dropBlocks(uint32_t slot) {
+        ChunkData& data = chunks[slot].data;
+        if (!data.edited) data.blocks = {};
     }
 
-    LowDetailChunk& generateChunkLOD(int x, int z, int LOD) {
-        Chunk* chunk = getChunk(x, z);
-        if (!chunk) {
-            auto [it, b] = LODs[LOD-1].emplace(Chunk::getId(x, z), LOD);
-            return it->second;
-        }
-        auto [it, b] = LODs[LOD-1].emplace(Chunk::getId(x, z), std::move(LowDetailChunk(LOD, *chunk)));
-        return it->second;
+    // Sets block at world position. Sections touching the block are marked
+    // dirty, in neighbouring chunks too when block lies on the chunk edge, and
+    // in the diagonal one on a corner column (its AO reads the block).
+    // Positions above or below the world are ignored
+    void changeBlock(const glm::ivec3& pos, BlockType type) {
+        if (pos.y < 0 || pos.y >= Chunk::HEIGHT) return;
+        const glm::ivec2 coords = Chunk::getChunkCoords(pos);
+        const glm::ivec3 local{pos.x - coords.x * Chunk::WIDTH, pos.y, pos.z - coords.y * Chunk::DEPTH};
+
+        const uint32_t slot = getSlot(coords.x, coords.y);
+        const BlockType old = chunks[slot].data.getBlock(local);
+        chunks[slot].data.changeBlock(local, type);
+        chunks[slot].data.edited = true;
+        revision_++;
+        const LightEngine::BlockChange change{static_cast<uint32_t>(ChunkData::getIndex(local)), old, type};
+        light_.reserveSlots(chunks.slotCount());
+        light_.onBlocksChanged(*this, slot, {&change, 1});
+        // pyramid is rebuilt from new blocks when needed again
+        if (slot < LODs.size()) LODs[slot].clear();
+
+        const int height = tree.getHeight(coords);
+        if (type != BlockType::AIR && pos.y >= height)
+            tree.insert(coords, slot, pos.y + 1);
+        else if (type == BlockType::AIR && pos.y == height - 1)
+            tree.insert(coords, slot, chunks[slot].data.getTopHeight());
+
+        const uint8_t sections = ChunkData::sectionMask(pos.y);
+        if (local.x == 0) markNeighbourDirty(coords.x - 1, coords.y, sections);
+        if (local.x == Chunk::WIDTH - 1) markNeighbourDirty(coords.x + 1, coords.y, sections);
+        if (local.z == 0) markNeighbourDirty(coords.x, coords.y - 1, sections);
+        if (local.z == Chunk::DEPTH - 1) markNeighbourDirty(coords.x, coords.y + 1, sections);
+        const int cornerX = local.x == 0 ? -1 : local.x == Chunk::WIDTH - 1 ? 1 : 0;
+        const int cornerZ = local.z == 0 ? -1 : local.z == Chunk::DEPTH - 1 ? 1 : 0;
+        if (cornerX && cornerZ) markNeighbourDirty(coords.x + cornerX, coords.y + cornerZ, sections);
+    }
+
+    // Applies all edits of the batch. Chunks are written in parallel and every
+    // touched section is invalidated once, however many edits it got
+    void apply(const BlockEditBatch& batch);
+
+    // Changes every time blocks or loaded chunks change
+    uint64_t getRevision() const { return revision_; }
+
+    void unloadChunk(uint32_t slot) {
+        revision_++;
+        tree.erase({chunks[slot].xCoord, chunks[slot].zCoord});
+        light_.unload(slot);
+        chunks.erase(slot);
+        if (slot < LODs.size()) LODs[slot].clear();
+    }
+
+private:
+    WorldGenerator generator_;
+    LightEngine light_;
+    uint64_t revision_ = 0;
+
+    // neighbour which is not loaded has no mesh to update
+    void markNeighbourDirty(int x, int z, uint8_t sections) {
+        const uint32_t slot = chunks.findSlot(x, z);
+        if (slot != ChunkMap::NO_SLOT) chunks[slot].data.dirtySections |= sections;
     }
 };
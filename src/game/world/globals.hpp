@@ -1,3 +1,7 @@
 #pragma once
 
 constexpr inline static int LOD_LEVELS = 5;
+// Width (in chunks) of the full detail ring, every next LOD ring is twice as wide
+constexpr inline static int LOD_DISTANCE = 8;
+// Distance (in chunks) the camera must move past a ring border before LOD changes
+constexpr inline static float LOD_HYSTERESIS = 1.0f;
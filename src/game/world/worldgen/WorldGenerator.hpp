@@ -6,14 +6,11 @@ class WorldGenerator {
 public:
     explicit WorldGenerator(unsigned seed = 0) : terrainNoise(seed) {}
 
-    Chunk& generateChunk(int x, int z, std::unordered_map<size_t, Chunk>& chunks) const {
-        size_t id = Chunk::getId(x, z);
-
-        Chunk& generated = chunks.emplace(id, glm::ivec2{x, z}).first->second;
+    void generateChunk(Chunk& generated) const {
         auto& blocks = generated.getBlocks();
 
-        const int worldX0 = x * Chunk::WIDTH;
-        const int worldZ0 = z * Chunk::DEPTH;
+        const int worldX0 = generated.xCoord * Chunk::WIDTH;
+        const int worldZ0 = generated.zCoord * Chunk::DEPTH;
 
         // Terrain parameters
         constexpr float SCALE = 0.01f;
@@ -55,8 +52,6 @@ public:
                 }
             }
         }
-
-        return generated;
     }
 
 private:
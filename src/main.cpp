@@ -1,8 +1,21 @@
+#include <algorithm>
+#include <string_view>
+#include <thread>
+
 #include "Application.h"
-#include "game/data_loaders/JsonLoader.h"
+#include "game/data_loaders/AssetBundle.h"
+#include "utils/JobSystem.hpp"
+
+int main(int argc, char* argv[]) {
+    // every job runs on the main thread in a fixed order, for debugging
+    const bool singleThread = argc > 1 && std::string_view(argv[1]) == "--single-thread";
+    jobSystem.start(singleThread ? 0 : std::max(std::thread::hardware_concurrency(), 1u) - 1);
 
-int main() {
-    JsonLoader k("assets");
+    // packs the assets folder into a bundle and exits, no window is opened
+    if (argc > 1 && std::string_view(argv[1]) == "--pack-assets") {
+        AssetBundle::pack("assets", AssetBundle::DEFAULT_PATH);
+        return 0;
+    }
     Application a{};
     a.Run();
     return 0;
@@ -68,9 +68,26 @@ void Camera::updateMatrices() {
 
 
 Frustum Camera::getFrustum() const {
-    //black magic code i don't understand it
-    const glm::mat4 vp = projection * view;
+    return planesOf(projection * view);
+}
 
+Frustum Camera::getFrustum(const float angleMargin, const float distanceMargin) const {
+    // field of view widened by the margin on every side
+    const float tanY = 1.0f / projection[1][1];
+    const float tanX = 1.0f / projection[0][0];
+    const float wideY = std::tan(std::atan(tanY) + angleMargin);
+    const float wideX = std::tan(std::atan(tanX) + angleMargin);
+    // far corners of a turned camera reach up to their distance along the view direction
+    const float farDistance = zFar * std::sqrt(1.0f + tanX * tanX + tanY * tanY);
+    const glm::mat4 widened = glm::perspective(2.0f * std::atan(wideY), wideX / wideY, zNear, farDistance);
+
+    Frustum frustum = planesOf(widened * view);
+    for (auto& plane : frustum.planes) plane.data.w += distanceMargin;
+    return frustum;
+}
+
+Frustum Camera::planesOf(const glm::mat4& vp) {
+    //black magic code i don't understand it
     const glm::mat4 vpt = glm::transpose(vp);
 
     std::array<Plane, 6> frustumPlanes = {
@@ -25,6 +25,9 @@ public:
 
     Frustum getFrustum() const;
 
+    // Frustum of every camera turned by at most angleMargin (radians) and moved by at most distanceMargin
+    Frustum getFrustum(float angleMargin, float distanceMargin) const;
+
     const glm::vec3& getDirection() const { return Front; }
     const glm::vec3& getPosition() const {return Position; }
 
@@ -53,4 +56,6 @@ private:
     const float zNear = 0.1f;
 
     void updateMatrices();
+
+    static Frustum planesOf(const glm::mat4& viewProjection);
 };
@@ -0,0 +1,86 @@
+#include "CaveCuller.hpp"
+
+#include <cmath>
+
+#include "game/world/World.h"
+
+namespace {
+    // neighbour section through face, indexed by Facing
+    constexpr glm::ivec3 STEP[6] = {{-1, 0, 0}, {1, 0, 0}, {0, 0, -1}, {0, 0, 1}, {0, 1, 0}, {0, -1, 0}};
+
+    Facing opposite(const int face) { return static_cast<Facing>(face ^ 1); }
+
+    int toSection(const float coord, const int size) {
+        return static_cast<int>(std::floor(coord / size));
+    }
+}
+
+void CaveCuller::update(const World& world, const glm::vec3& camera, const Frustum& frustum,
+                        const float radius) {
+    const ChunkMap& chunks = world.chunks;
+    reached.assign(chunks.slotCount(), 0);
+    queue.clear();
+
+    const glm::ivec3 start{
+        toSection(camera.x, Chunk::WIDTH),
+        toSection(camera.y, Chunk::SUB_HEIGHT),
+        toSection(camera.z, Chunk::DEPTH)
+    };
+    active = chunks.findSlot(start.x, start.z) != ChunkMap::NO_SLOT;
+    if (!active) return;
+
+    const auto visit = [&](const glm::ivec3& pos, const uint8_t entered, const uint8_t directions) {
+        if (pos.y < 0 || pos.y >= Chunk::SUB_COUNT) return;
+
+        const float dx = (pos.x + 0.5f) * Chunk::WIDTH - camera.x;
+        const float dz = (pos.z + 0.5f) * Chunk::DEPTH - camera.z;
+        if (dx * dx + dz * dz > radius * radius) return;
+
+        const uint32_t slot = chunks.findSlot(pos.x, pos.z);
+        if (slot == ChunkMap::NO_SLOT || reached[slot] & 1 << pos.y) return;
+
+        // camera section is entered even when camera looks away from it
+        if (entered != NO_FACE) {
+            const glm::vec3 min(pos.x * Chunk::WIDTH, pos.y * Chunk::SUB_HEIGHT, pos.z * Chunk::DEPTH);
+            if (!frustum.isAABBVisible({min, min + glm::vec3(Chunk::WIDTH, Chunk::SUB_HEIGHT, Chunk::DEPTH)}))
+                return;
+        }
+
+        reached[slot] |= 1 << pos.y;
+        queue.push_back({pos, entered, directions});
+    };
+
+    if (start.y >= Chunk::SUB_COUNT || start.y < 0) {
+        // camera above or below the world looks in through the top or bottom of every chunk
+        const bool above = start.y >= 0;
+        const int y = above ? Chunk::SUB_COUNT - 1 : 0;
+        const int reach = static_cast<int>(std::ceil(radius / Chunk::WIDTH));
+        for (int x = start.x - reach; x <= start.x + reach; x++)
+            for (int z = start.z - reach; z <= start.z + reach; z++)
+                visit({x, y, z}, above ? UP : DOWN, 1 << (above ? DOWN : UP));
+    } else {
+        visit(start, NO_FACE, 0);
+    }
+
+    for (size_t i = 0; i < queue.size(); i++) {
+        const Node node = queue[i];
+        const Chunk& chunk = chunks[chunks.findSlot(node.pos.x, node.pos.z)];
+        // section waiting for remesh may have been dug through already
+        const SectionVisibility visibility = chunk.data.dirtySections & 1 << node.pos.y
+                                                 ? SectionVisibility{}
+                                                 : chunk.data.visibility[node.pos.y];
+
+        for (int face = 0; face < 6; face++) {
+            if (node.directions & 1 << opposite(face)) continue;
+            if (node.entered != NO_FACE &&
+                !visibility.connected(static_cast<Facing>(node.entered), static_cast<Facing>(face)))
+                continue;
+            visit(node.pos + STEP[face], opposite(face), node.directions | 1 << face);
+        }
+    }
+}
+
+uint8_t CaveCuller::getSections(const uint32_t slot) const {
+    if (!active) return ChunkData::ALL_SECTIONS;
+    return slot < reached.size() ? reached[slot] : 0;
+}
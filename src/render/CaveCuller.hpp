@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+
+class World;
+
+// Sections the camera may see, found by walking from the camera section through neighbours in the
+// frustum. A section is left only through faces connected to the face it was entered by
+// (SectionVisibility), and the walk never turns back towards the camera
+class CaveCuller {
+public:
+    // radius is horizontal distance (in blocks) of chunk centres still drawn
+    void update(const World& world, const glm::vec3& camera, const Frustum& frustum, float radius);
+
+    // Reachable sections of chunk slot, all when camera is not in a loaded chunk
+    uint8_t getSections(uint32_t slot) const;
+
+private:
+    struct Node {
+        glm::ivec3 pos; // chunk x, section, chunk z
+        uint8_t entered; // face walk entered section by, NO_FACE in the first one
+        uint8_t directions; // faces walk already stepped out of, never stepped back
+    };
+
+    static constexpr uint8_t NO_FACE = 6;
+
+    bool active = false;
+    // reached sections per slot
+    std::vector<uint8_t> reached;
+    std::vector<Node> queue;
+};
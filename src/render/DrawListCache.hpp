@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+
+// Decides whether the draw list of the last frame can be reused.
+// Culling is done for a whole camera cell and orientation bucket at once (with a widened frustum),
+// so while the camera stays in them only exact per-section tests have to be redone (PATCH). When
+// nothing moved at all, the last indirect commands are submitted again as they are (HIT)
+class DrawListCache {
+public:
+    // side of camera cell in blocks
+    static constexpr int CELL_SIZE = 4;
+    // yaw and pitch bucket in degrees
+    static constexpr float ORIENTATION_BUCKET = 4.0f;
+    static_assert(Chunk::SUB_HEIGHT % CELL_SIZE == 0, "cell must stay in one section");
+
+    enum class Result { HIT, PATCH, MISS };
+
+    struct Key {
+        glm::ivec3 cell{};
+        glm::ivec2 orientation{};
+        int viewDistance = 0;
+        // sum of world, residency and mesh revisions
+        uint64_t revision = 0;
+        glm::mat4 projection{};
+
+        bool operator==(const Key&) const = default;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t patches = 0;
+        uint64_t misses = 0;
+        // CPU time not spent compared to rebuilding on every frame
+        double microsecondsSaved = 0;
+
+        double hitRate() const {
+            const uint64_t frames = hits + patches + misses;
+            return frames ? static_cast<double>(hits + patches) / frames : 0.0;
+        }
+    };
+
+    static Key makeKey(const Camera& camera, const uint64_t revision) {
+        const glm::vec3& front = camera.getFront();
+        const float yaw = glm::degrees(std::atan2(front.z, front.x));
+        const float pitch = glm::degrees(std::asin(glm::clamp(front.y, -1.0f, 1.0f)));
+        return {
+            glm::ivec3(glm::floor(camera.Position / static_cast<float>(CELL_SIZE))),
+            glm::ivec2(std::floor(yaw / ORIENTATION_BUCKET), std::floor(pitch / ORIENTATION_BUCKET)),
+            camera.viewDistance, revision, camera.getProjectionMatrix()
+        };
+    }
+
+    // How far cached culling has to reach past the camera, so it holds for the whole cell and bucket
+    static float positionMargin() { return CELL_SIZE * std::sqrt(3.0f); }
+    static float angleMargin() { return glm::radians(2 * ORIENTATION_BUCKET); }
+
+    Result lookup(const Key& key, const glm::mat4& view) {
+        Result result = Result::MISS;
+        if (valid && key == this->key) result = view == this->view ? Result::HIT : Result::PATCH;
+        this->key = key;
+        this->view = view;
+        valid = true;
+        return result;
+    }
+
+    // Accounts CPU time the frame took to prepare its draw list
+    void finish(const Result result, const double microseconds) {
+        switch (result) {
+        case Result::HIT: stats.hits++; break;
+        case Result::PATCH: stats.patches++; break;
+        case Result::MISS:
+            stats.misses++;
+            rebuildMicroseconds = microseconds;
+            return;
+        }
+        stats.microsecondsSaved += std::max(0.0, rebuildMicroseconds - microseconds);
+    }
+
+    void invalidate() { valid = false; }
+
+    const Stats& getStats() const { return stats; }
+    void resetStats() { stats = {}; }
+
+private:
+    bool valid = false;
+    Key key;
+    glm::mat4 view{};
+    // cost of the last full rebuild
+    double rebuildMicroseconds = 0;
+    Stats stats;
+};
@@ -0,0 +1,129 @@
+#include "FrustumCuller.hpp"
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "game/world/Chunk.h"
+
+namespace {
+    int floorDiv(const int a, const int b) {
+        return a / b - (a % b != 0 && (a < 0) != (b < 0));
+    }
+
+    AABB columnBox(const glm::ivec2& min, const glm::ivec2& max) {
+        return {
+            glm::vec3(min.x * Chunk::WIDTH, 0, min.y * Chunk::DEPTH),
+            glm::vec3(max.x * Chunk::WIDTH, Chunk::HEIGHT, max.y * Chunk::DEPTH)
+        };
+    }
+
+    // section bounds along y, lane per section
+    template <int OFFSET>
+    constexpr auto sectionY() {
+        std::array<float, Chunk::SUB_COUNT> y{};
+        for (int i = 0; i < Chunk::SUB_COUNT; i++) y[i] = static_cast<float>((i + OFFSET) * Chunk::SUB_HEIGHT);
+        return y;
+    }
+    alignas(32) constexpr auto SECTION_MIN_Y = sectionY<0>();
+    alignas(32) constexpr auto SECTION_MAX_Y = sectionY<1>();
+}
+
+Containment FrustumCuller::classify(const AABB& box) const {
+    Containment result = Containment::INSIDE;
+    for (const auto& plane : planes) {
+        const glm::vec4& p = plane.data;
+        // corners farthest along and against the normal
+        const glm::vec3 farCorner(p.x > 0 ? box.max.x : box.min.x, p.y > 0 ? box.max.y : box.min.y,
+                                  p.z > 0 ? box.max.z : box.min.z);
+        const glm::vec3 nearCorner(p.x > 0 ? box.min.x : box.max.x, p.y > 0 ? box.min.y : box.max.y,
+                                   p.z > 0 ? box.min.z : box.max.z);
+        if (p.x * farCorner.x + p.y * farCorner.y + p.z * farCorner.z + p.w < 0) return Containment::OUTSIDE;
+        if (p.x * nearCorner.x + p.y * nearCorner.y + p.z * nearCorner.z + p.w < 0) result = Containment::PARTIAL;
+    }
+    return result;
+}
+
+void FrustumCuller::cull(std::span<const glm::ivec2> columns, std::span<uint8_t> sections) {
+    stats = {};
+    if (columns.empty()) return;
+
+    glm::ivec2 regionMin(INT32_MAX), regionMax(INT32_MIN);
+    for (const auto& column : columns) {
+        const glm::ivec2 region(floorDiv(column.x, REGION_SIZE), floorDiv(column.y, REGION_SIZE));
+        regionMin = glm::min(regionMin, region);
+        regionMax = glm::max(regionMax, region);
+    }
+    const int regionsWide = regionMax.x - regionMin.x + 1;
+    regions.assign(regionsWide * (regionMax.y - regionMin.y + 1), std::nullopt);
+
+    for (size_t i = 0; i < columns.size(); i++) {
+        const glm::ivec2& column = columns[i];
+        const glm::ivec2 region(floorDiv(column.x, REGION_SIZE), floorDiv(column.y, REGION_SIZE));
+        auto& regionState = regions[(region.y - regionMin.y) * regionsWide + region.x - regionMin.x];
+        if (!regionState) {
+            regionState = classify(columnBox(region * REGION_SIZE, (region + 1) * REGION_SIZE));
+            stats.regions++;
+        }
+
+        Containment state = *regionState;
+        if (state == Containment::PARTIAL) {
+            state = classify(columnBox(column, column + 1));
+            stats.columns++;
+        }
+
+        if (state == Containment::PARTIAL) {
+            sections[i] = testSections(column);
+            stats.sections += Chunk::SUB_COUNT;
+        } else {
+            sections[i] = state == Containment::INSIDE ? ChunkData::ALL_SECTIONS : 0;
+        }
+    }
+}
+
+uint8_t FrustumCuller::testSections(const glm::ivec2& column) const {
+    const float x0 = static_cast<float>(column.x * Chunk::WIDTH);
+    const float z0 = static_cast<float>(column.y * Chunk::DEPTH);
+
+#if defined(__AVX2__)
+    static_assert(Chunk::SUB_COUNT == 8, "sections must fill AVX lanes");
+    __m256 outside = _mm256_setzero_ps();
+    for (const auto& plane : planes) {
+        const glm::vec4& p = plane.data;
+        // x and z are shared by all sections of the column
+        const float xz = p.x * (p.x > 0 ? x0 + Chunk::WIDTH : x0) + p.z * (p.z > 0 ? z0 + Chunk::DEPTH : z0) + p.w;
+        const __m256 y = _mm256_load_ps((p.y > 0 ? SECTION_MAX_Y : SECTION_MIN_Y).data());
+        const __m256 d = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.y), y), _mm256_set1_ps(xz));
+        outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_LT_OQ));
+    }
+    return ~_mm256_movemask_ps(outside) & ChunkData::ALL_SECTIONS;
+#elif defined(__SSE2__)
+    static_assert(Chunk::SUB_COUNT % 4 == 0, "sections must fill SSE lanes");
+    uint8_t visible = 0;
+    for (int first = 0; first < Chunk::SUB_COUNT; first += 4) {
+        __m128 outside = _mm_setzero_ps();
+        for (const auto& plane : planes) {
+            const glm::vec4& p = plane.data;
+            const float xz = p.x * (p.x > 0 ? x0 + Chunk::WIDTH : x0) + p.z * (p.z > 0 ? z0 + Chunk::DEPTH : z0) + p.w;
+            const __m128 y = _mm_load_ps((p.y > 0 ? SECTION_MAX_Y : SECTION_MIN_Y).data() + first);
+            const __m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.y), y), _mm_set1_ps(xz));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(d, _mm_setzero_ps()));
+        }
+        visible |= (~_mm_movemask_ps(outside) & 0xF) << first;
+    }
+    return visible;
+#else
+    uint8_t visible = ChunkData::ALL_SECTIONS;
+    for (const auto& plane : planes) {
+        const glm::vec4& p = plane.data;
+        const float xz = p.x * (p.x > 0 ? x0 + Chunk::WIDTH : x0) + p.z * (p.z > 0 ? z0 + Chunk::DEPTH : z0) + p.w;
+        for (int y = 0; y < Chunk::SUB_COUNT; y++)
+            if (p.y * (p.y > 0 ? SECTION_MAX_Y : SECTION_MIN_Y)[y] + xz < 0) visible &= ~(1 << y);
+    }
+    return visible;
+#endif
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+
+// Frustum test of all sub-chunks in range at once.
+// Regions of chunk columns are tested first, then columns, and only sections of columns crossing
+// the frustum border are tested. Sections of a column are SIMD lanes, all 8 are tested at once
+// with AVX2 (4 with SSE2) against the corner farthest along each plane normal
+class FrustumCuller {
+public:
+    // chunk columns per region side
+    static constexpr int REGION_SIZE = 8;
+
+    struct Stats {
+        uint32_t regions = 0; // regions tested
+        uint32_t columns = 0; // columns tested, rest was decided by their region
+        uint32_t sections = 0; // sections tested, rest was decided by their column
+    };
+
+    void setFrustum(const Frustum& frustum) { planes = frustum.planes; }
+
+    // Writes visible sections of every chunk column, sections[i] belongs to columns[i]
+    void cull(std::span<const glm::ivec2> columns, std::span<uint8_t> sections);
+
+    Containment classify(const AABB& box) const;
+
+    // visible sections of column crossing the frustum border
+    uint8_t testSections(const glm::ivec2& column) const;
+
+    // stats of the last cull
+    const Stats& getStats() const { return stats; }
+
+private:
+    std::array<Plane, 6> planes;
+    Stats stats;
+
+    std::vector<std::optional<Containment>> regions;
+};
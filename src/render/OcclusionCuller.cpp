@@ -0,0 +1,228 @@
+#include "OcclusionCuller.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // corners closer than this to the camera plane cannot be projected
+    constexpr float NEAR_W = 0.1f;
+
+    // screen position in pixels and 1/w, false if point is too close or behind camera
+    bool project(const glm::mat4& viewProjection, const glm::vec3& point, glm::vec3& out) {
+        const glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+        if (clip.w < NEAR_W) return false;
+        const float invW = 1.0f / clip.w;
+        out = {
+            (clip.x * invW * 0.5f + 0.5f) * OcclusionCuller::WIDTH,
+            (clip.y * invW * 0.5f + 0.5f) * OcclusionCuller::HEIGHT,
+            invW
+        };
+        return true;
+    }
+}
+
+void OcclusionCuller::begin(const glm::mat4& viewProjection, const glm::vec3& camera) {
+    this->viewProjection = viewProjection;
+    this->camera = camera;
+
+    if (levels.empty()) {
+        for (int w = WIDTH, h = HEIGHT; w > 0 && h > 0; w /= 2, h /= 2)
+            levels.emplace_back(w * h);
+    }
+    std::ranges::fill(levels[0], 0.0f);
+    empty = true;
+}
+
+void OcclusionCuller::addOccluder(const AABB& box) {
+    // only faces looking at the camera, the back ones are behind them anyway
+    for (int axis = 0; axis < 3; axis++) {
+        float plane;
+        if (camera[axis] < box.min[axis]) plane = box.min[axis];
+        else if (camera[axis] > box.max[axis]) plane = box.max[axis];
+        else continue;
+
+        const int u = (axis + 1) % 3;
+        const int v = (axis + 2) % 3;
+        glm::vec3 corners[4];
+        for (int i = 0; i < 4; i++) {
+            glm::vec3 corner;
+            corner[axis] = plane;
+            corner[u] = i == 1 || i == 2 ? box.max[u] : box.min[u];
+            corner[v] = i >= 2 ? box.max[v] : box.min[v];
+            corners[i] = corner;
+        }
+
+        glm::vec3 quad[4];
+        bool projected = true;
+        for (int i = 0; i < 4 && projected; i++)
+            projected = project(viewProjection, corners[i], quad[i]);
+        // faces crossing camera plane are dropped, occluders only need to be conservative
+        if (projected) rasterizeQuad(quad);
+    }
+}
+
+void OcclusionCuller::rasterizeQuad(const glm::vec3 (&quad)[4]) {
+    // 1/w plane over screen from 3 corners, the face is planar
+    const glm::vec3 d1 = quad[1] - quad[0];
+    const glm::vec3 d2 = quad[2] - quad[0];
+    const float area = d1.x * d2.y - d2.x * d1.y;
+    if (std::abs(area) < 1e-6f) return;
+    const float dzdx = (d1.z * d2.y - d2.z * d1.y) / area;
+    const float dzdy = (d1.x * d2.z - d2.x * d1.z) / area;
+    // pixels take the farthest depth the face has anywhere inside them, not the one at their center
+    const float z0 = quad[0].z - dzdx * quad[0].x - dzdy * quad[0].y -
+                     0.5f * (std::abs(dzdx) + std::abs(dzdy));
+    float zMin = quad[0].z;
+    for (const auto& corner : quad) zMin = std::min(zMin, corner.z);
+
+    // edge functions, positive inside whatever the winding is. Moved inwards by half a pixel,
+    // so a pixel centre is inside only when the corner farthest out is, and partly covered
+    // pixels are never written: what shows through their uncovered part must not be culled
+    float edgeA[4], edgeB[4], edgeC[4];
+    const float orientation = area > 0 ? 1.0f : -1.0f;
+    for (int i = 0; i < 4; i++) {
+        const glm::vec3& a = quad[i];
+        const glm::vec3& b = quad[(i + 1) % 4];
+        edgeA[i] = -(b.y - a.y) * orientation;
+        edgeB[i] = (b.x - a.x) * orientation;
+        edgeC[i] = -edgeA[i] * a.x - edgeB[i] * a.y - 0.5f * (std::abs(edgeA[i]) + std::abs(edgeB[i]));
+    }
+
+    float xMin = quad[0].x, xMax = quad[0].x, yMin = quad[0].y, yMax = quad[0].y;
+    for (const auto& corner : quad) {
+        xMin = std::min(xMin, corner.x);
+        xMax = std::max(xMax, corner.x);
+        yMin = std::min(yMin, corner.y);
+        yMax = std::max(yMax, corner.y);
+    }
+    // 4 pixel aligned, so rows are processed 4 pixels at a time
+    const int x0 = std::max(0, static_cast<int>(std::floor(xMin))) & ~3;
+    const int x1 = std::min(WIDTH - 1, static_cast<int>(std::floor(xMax)));
+    const int y0 = std::max(0, static_cast<int>(std::floor(yMin)));
+    const int y1 = std::min(HEIGHT - 1, static_cast<int>(std::floor(yMax)));
+    if (x0 > x1 || y0 > y1) return;
+    empty = false;
+
+    std::vector<float>& depth = levels[0];
+
+#ifdef __SSE2__
+    const __m128 lane = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 zMinV = _mm_set1_ps(zMin);
+    const __m128 zStep = _mm_set1_ps(dzdx * 4);
+    __m128 eStep[4];
+    for (int i = 0; i < 4; i++) eStep[i] = _mm_set1_ps(edgeA[i] * 4);
+
+    for (int y = y0; y <= y1; y++) {
+        const float py = y + 0.5f;
+        __m128 e[4];
+        for (int i = 0; i < 4; i++)
+            e[i] = _mm_add_ps(_mm_set1_ps(edgeA[i] * x0 + edgeB[i] * py + edgeC[i]),
+                              _mm_mul_ps(_mm_set1_ps(edgeA[i]), lane));
+        __m128 z = _mm_add_ps(_mm_set1_ps(dzdx * x0 + dzdy * py + z0),
+                              _mm_mul_ps(_mm_set1_ps(dzdx), lane));
+
+        float* row = depth.data() + y * WIDTH;
+        for (int x = x0; x <= x1; x += 4) {
+            const __m128 inside = _mm_and_ps(
+                _mm_and_ps(_mm_cmpge_ps(e[0], zero), _mm_cmpge_ps(e[1], zero)),
+                _mm_and_ps(_mm_cmpge_ps(e[2], zero), _mm_cmpge_ps(e[3], zero)));
+            if (_mm_movemask_ps(inside)) {
+                const __m128 old = _mm_loadu_ps(row + x);
+                const __m128 nearer = _mm_max_ps(old, _mm_max_ps(z, zMinV));
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+            }
+            for (int i = 0; i < 4; i++) e[i] = _mm_add_ps(e[i], eStep[i]);
+            z = _mm_add_ps(z, zStep);
+        }
+    }
+#else
+    for (int y = y0; y <= y1; y++) {
+        const float py = y + 0.5f;
+        float* row = depth.data() + y * WIDTH;
+        for (int x = x0; x <= x1; x++) {
+            const float px = x + 0.5f;
+            bool inside = true;
+            for (int i = 0; i < 4; i++)
+                inside &= edgeA[i] * px + edgeB[i] * py + edgeC[i] >= 0;
+            if (!inside) continue;
+            row[x] = std::max(row[x], std::max(zMin, dzdx * px + dzdy * py + z0));
+        }
+    }
+#endif
+}
+
+void OcclusionCuller::finish() {
+    if (empty) return;
+    for (size_t level = 1; level < levels.size(); level++) {
+        const int width = WIDTH >> level;
+        const int height = HEIGHT >> level;
+        const std::vector<float>& below = levels[level - 1];
+        std::vector<float>& texels = levels[level];
+        for (int y = 0; y < height; y++) {
+            const float* row0 = below.data() + 2 * y * (2 * width);
+            const float* row1 = row0 + 2 * width;
+            for (int x = 0; x < width; x++) {
+                texels[y * width + x] = std::min(std::min(row0[2 * x], row0[2 * x + 1]),
+                                                 std::min(row1[2 * x], row1[2 * x + 1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::isVisible(const AABB& box) {
+    std::atomic_ref(stats.tested).fetch_add(1, std::memory_order_relaxed);
+    if (empty) return true;
+
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(std::numeric_limits<float>::lowest());
+    for (int i = 0; i < 8; i++) {
+        const glm::vec3 corner{
+            i & 1 ? box.max.x : box.min.x,
+            i & 2 ? box.max.y : box.min.y,
+            i & 4 ? box.max.z : box.min.z
+        };
+        glm::vec3 screen;
+        // box reaching behind camera plane covers half of the screen
+        if (!project(viewProjection, corner, screen)) return true;
+        min = glm::min(min, screen);
+        max = glm::max(max, screen);
+    }
+    if (max.x < 0 || max.y < 0 || min.x >= WIDTH || min.y >= HEIGHT) return true;
+
+    int x0 = std::max(0, static_cast<int>(min.x));
+    int x1 = std::min(WIDTH - 1, static_cast<int>(max.x));
+    int y0 = std::max(0, static_cast<int>(min.y));
+    int y1 = std::min(HEIGHT - 1, static_cast<int>(max.y));
+
+    // level where the box covers at most 2x2 texels
+    size_t level = 0;
+    while (level + 1 < levels.size() && (x1 - x0 > 1 || y1 - y0 > 1)) {
+        x0 >>= 1, x1 >>= 1, y0 >>= 1, y1 >>= 1;
+        level++;
+    }
+
+    const int width = WIDTH >> level;
+    const std::vector<float>& texels = levels[level];
+    float farthest = texels[y0 * width + x0];
+    for (int y = y0; y <= y1; y++)
+        for (int x = x0; x <= x1; x++)
+            farthest = std::min(farthest, texels[y * width + x]);
+
+    // nearest point of the box is behind every occluder there
+    if (max.z < farthest) {
+        std::atomic_ref(stats.culled).fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+float OcclusionCuller::getDepth(const int x, const int y, const int level) const {
+    return levels[level][y * (WIDTH >> level) + x];
+}
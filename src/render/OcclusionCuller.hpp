@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "utils/AABB.hpp"
+
+// Software occlusion culling.
+// Solid boxes close to the camera are rasterized into a small depth buffer on the CPU, boxes about
+// to be drawn are tested against a pyramid of it. No GPU and no readback is involved, so results are
+// ready in the same frame. Depth is kept as 1/w, which is linear in screen space, larger is nearer
+class OcclusionCuller {
+public:
+    static constexpr int WIDTH = 256;
+    static constexpr int HEIGHT = 128;
+    static_assert(WIDTH % 4 == 0, "rows are rasterized 4 pixels at a time");
+
+    struct Stats {
+        uint64_t tested = 0;
+        uint64_t culled = 0;
+    };
+
+    // Clears depth for a new frame
+    void begin(const glm::mat4& viewProjection, const glm::vec3& camera);
+
+    // Box must be completely filled with opaque blocks
+    void addOccluder(const AABB& box);
+
+    // Builds the pyramid, call after all occluders were added
+    void finish();
+
+    // false only if box is hidden behind occluders for sure. Safe to call from several threads
+    // once finished
+    bool isVisible(const AABB& box);
+
+    const Stats& getStats() const { return stats; }
+    void resetStats() { stats = {}; }
+
+    // 1/w at texel of pyramid level, 0 where nothing was drawn
+    float getDepth(int x, int y, int level = 0) const;
+    int getLevelCount() const { return static_cast<int>(levels.size()); }
+
+private:
+    glm::mat4 viewProjection{1.0f};
+    glm::vec3 camera{};
+    bool empty = true;
+    Stats stats;
+
+    // level 0 keeps nearest occluder of every pixel, every next level keeps
+    // the farthest of 2x2 texels below, so a texel hides only what all its pixels hide
+    std::vector<std::vector<float>> levels;
+
+    void rasterizeQuad(const glm::vec3 (&quad)[4]);
+};
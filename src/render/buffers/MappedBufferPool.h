@@ -1,46 +1,48 @@
 #pragma once
 
-#include <unordered_map>
+#include <vector>
 
 #include "Allocator.hpp"
+#include "game/world/BlockRegistry.hpp"
+#include "utils/AABB.hpp"
 
 namespace GPU {
 
+// Mesh allocations of chunks, indexed by world chunk slot (see ChunkMap)
 class MappedChunkBuffer {
    public:
     explicit MappedChunkBuffer(int capacity = 0) : allocator(capacity) {
         m_allocs.reserve(capacity);
     }
 
-    Allocator::MemoryBlock getAllocation(size_t chunkId) {
-        auto it = m_allocs.find(chunkId);
-        if (it != m_allocs.end()) {
-            return allocator[it->second];
+    Allocator::MemoryBlock getAllocation(uint32_t slot) {
+        if (containsAllocation(slot)) {
+            return allocator[m_allocs[slot]];
         }
         return Allocator::MemoryBlock{0, 0, true};
     }
 
-    Allocator::MemoryBlock allocate(size_t id, size_t capacity = 0) {
-        auto [it, inserted] =
-            m_allocs.try_emplace(id, allocator.alloc(capacity));
-        return allocator[it->second];
+    Allocator::MemoryBlock allocate(uint32_t slot, size_t capacity = 0) {
+        reserveSlots(slot + 1);
+        if (m_allocs[slot] == NO_ALLOCATION)
+            m_allocs[slot] = allocator.alloc(capacity);
+        return getAllocation(slot);
     }
 
-    void deallocate(size_t id) {
-        auto it = m_allocs.find(id);
-        if (it == m_allocs.end()) return;
-        allocator.dealloc(it->second);
-        m_allocs.erase(it);
+    void deallocate(uint32_t slot) {
+        if (!containsAllocation(slot)) return;
+        allocator.dealloc(m_allocs[slot]);
+        m_allocs[slot] = NO_ALLOCATION;
+        chunkViewData[slot] = {};
     }
 
-    bool containsAllocation(size_t id) {
-        return m_allocs.find(id) != m_allocs.end();
+    bool containsAllocation(uint32_t slot) const {
+        return slot < m_allocs.size() && m_allocs[slot] != NO_ALLOCATION;
     }
 
-    void resizeAllocation(size_t id, size_t new_size) {
-        auto it = m_allocs.find(id);
-        if (it != m_allocs.end())
-            it->second = allocator.realloc(it->second, new_size);
+    void resizeAllocation(uint32_t slot, size_t new_size) {
+        if (containsAllocation(slot))
+            m_allocs[slot] = allocator.realloc(m_allocs[slot], new_size);
     }
 
     void sync() { allocator.sync(); }
@@ -49,10 +51,9 @@ class MappedChunkBuffer {
     u64 get_used_memory() const { return allocator.get_used_memory(); }
     GLuint get_buffer() const { return allocator.get_buffer(); }
 
-    void write(size_t id, void* data, size_t size, size_t offset) {
-        auto it = m_allocs.find(id);
-        if (it != m_allocs.end()) {
-            const auto& view = allocator[it->second];
+    void write(uint32_t slot, void* data, size_t size, size_t offset) {
+        if (containsAllocation(slot)) {
+            const auto& view = allocator[m_allocs[slot]];
             if (view.is_free) return;
             if (size + offset > view.size)
                 throw std::runtime_error(
@@ -66,14 +67,30 @@ class MappedChunkBuffer {
     struct GPUBufferView {
         size_t offset = 0;
         size_t size = 0;
+        AABB bounds{}; // around the faces, relative to the section origin
     };
-    typedef std::array<std::array<GPUBufferView, 6>, Chunk::SUB_COUNT>
+    // mesh of a section is split by render layer, every layer into 6 facing
+    // groups. Group of layer l and facing f is l * 6 + f
+    static constexpr int FACE_GROUPS = RENDER_LAYERS * 6;
+    static constexpr int faceGroup(const RenderLayer layer, const int facing) {
+        return static_cast<int>(layer) * 6 + facing;
+    }
+    typedef std::array<std::array<GPUBufferView, FACE_GROUPS>, Chunk::SUB_COUNT>
         ChunkBufferView;
 
-    std::unordered_map<u64, ChunkBufferView> chunkViewData;
+    // Buffer views of every chunk slot, empty for slots without mesh
+    std::vector<ChunkBufferView> chunkViewData;
+
+    void reserveSlots(uint32_t count) {
+        if (count <= m_allocs.size()) return;
+        m_allocs.resize(count, NO_ALLOCATION);
+        chunkViewData.resize(count);
+    }
 
    private:
-    std::unordered_map<size_t, size_t> m_allocs;
+    static constexpr size_t NO_ALLOCATION = -1;
+
+    std::vector<size_t> m_allocs;
     Allocator allocator;
 };
 }  // namespace GPU
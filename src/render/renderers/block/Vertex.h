@@ -12,10 +12,20 @@ struct Vertex {
     constexpr static VertexData layerShift = 11;
     constexpr static VertexData layerMask = (1 << layerShift) - 1;
 
+    // ambient occlusion of the corner, 0 is unoccluded
+    constexpr static VertexData aoShift = 2;
+    constexpr static VertexData aoMask = (1 << aoShift) - 1;
+    constexpr static VertexData aoOffset = 3 * coordShift + 2 * texShift + layerShift;
+
+    // sky light in high 4 bits, block light in low 4 bits
+    constexpr static VertexData lightShift = 8;
+    constexpr static VertexData lightMask = (1 << lightShift) - 1;
+    constexpr static VertexData lightOffset = aoOffset + aoShift;
+
     // constexpr static VertexData ;
 
     //(4free) 4light 11layer 6texU 6texV 11x 11y 11z - in the future update
-    //31 bits compacted: 11layer 1texX 1texY 6z 6y 6x
+    //51 bits compacted: 8light 2ao 11layer 6texV 6texU 6z 6y 6x
     VertexData data;
 
     constexpr Vertex(char x, char y, char z, int textureX, int textureY, int layer = 0) {
@@ -24,6 +34,22 @@ struct Vertex {
                 (layer & layerMask) << (3 * coordShift + 2 * texShift));
     }
 
+    constexpr void setAO(unsigned int ao) {
+        data = (data & ~(aoMask << aoOffset)) | ((ao & aoMask) << aoOffset);
+    }
+
+    unsigned int getAO() const {
+        return (data >> aoOffset) & aoMask;
+    }
+
+    constexpr void setLight(unsigned int light) {
+        data = (data & ~(lightMask << lightOffset)) | ((light & lightMask) << lightOffset);
+    }
+
+    unsigned int getLight() const {
+        return (data >> lightOffset) & lightMask;
+    }
+
     unsigned int getX() const {
         return data & coordMask;
     }
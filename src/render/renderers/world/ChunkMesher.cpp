@@ -1,60 +1,130 @@
 #include "ChunkMesher.h"
 
+#include <bit>
+
 #include <glm/vec2.hpp>
 
-std::array<bool, 6> ChunkMesher::checkAdjacentBlocks(
-    World& world, const ChunkData& chunkData, const glm::ivec2& chunkPos,
-    const glm::ivec3& blockPos) {
-    std::array<bool, 6> res{};
-
-    constexpr int extremePoses[6] = {
-        0, Chunk::WIDTH - 1, 0, Chunk::DEPTH - 1, Chunk::HEIGHT - 1, 0};
-    constexpr int affectedCoords[6] = {0, 0, 2, 2, 1, 1};
-    constexpr glm::ivec3 minBlockPoses[6] = {
-        glm::ivec3{Chunk::WIDTH - 1, 0, 0},
-        glm::ivec3{-Chunk::WIDTH + 1, 0, 0},
-        glm::ivec3{0, 0, Chunk::DEPTH - 1},
-        glm::ivec3{0, 0, -Chunk::DEPTH + 1},
-        glm::ivec3{0, -Chunk::HEIGHT + 1, 0},
-        glm::ivec3{0, Chunk::HEIGHT - 1, 0}};
-    constexpr glm::ivec2 chunkChanges[6] = {
-        glm::ivec2{-1, 0}, glm::ivec2{1, 0}, glm::ivec2{0, -1},
-        glm::ivec2{0, 1},  glm::ivec2{0, 0}, glm::ivec2{0, 0}};
-
-    // check x+ x- z+ z-
-    for (int f = 0; f < 4; f++) {
-        auto adjacentPos = blockPos;
-        bool chunkChanged = false;
-        if (adjacentPos[affectedCoords[f]] == extremePoses[f]) {
-            adjacentPos += minBlockPoses[f];
-            chunkChanged = true;
+namespace {
+// Plane axes and fixed axis for each facing
+constexpr std::tuple<int, int, int> axisMap[6] = {
+    {2, 1, 0},  // LEFT:   plane axes Z(axis1) and Y(axis2), fixed X
+    {2, 1, 0},  // RIGHT:  plane axes Z(axis1) and Y(axis2), fixed X
+    {0, 1, 2},  // FRONT:  plane axes X(axis1) and Y(axis2), fixed Z
+    {0, 1, 2},  // BACK:   plane axes X(axis1) and Y(axis2), fixed Z
+    {0, 2, 1},  // TOP:    plane axes X(axis1) and Z(axis2), fixed Y
+    {0, 2, 1}   // BOTTOM: plane axes X(axis1) and Z(axis2), fixed Y
+};
+
+// Face value in chunkFaces: texture layer in low bits, corner occlusion and
+// light of the block the face looks at above
+constexpr int AO_SHIFT = 16;
+constexpr int LIGHT_SHIFT = 24;
+
+// 2 bit occlusion of a face corner, corner (c1, c2) along (axis1, axis2)
+unsigned cornerAO(const unsigned ao, const int c1, const int c2) {
+    return (ao >> (2 * (c1 + 2 * c2))) & 3;
+}
+
+// merged quad interpolates AO between its corners, so faces may only be
+// stretched along an axis their occlusion does not change on
+bool uniformAlongAxis1(const unsigned ao) {
+    return cornerAO(ao, 0, 0) == cornerAO(ao, 1, 0) &&
+           cornerAO(ao, 0, 1) == cornerAO(ao, 1, 1);
+}
+
+bool uniformAlongAxis2(const unsigned ao) {
+    return cornerAO(ao, 0, 0) == cornerAO(ao, 0, 1) &&
+           cornerAO(ao, 1, 0) == cornerAO(ao, 1, 1);
+}
+}  // namespace
+
+void ChunkMesher::buildOccupancy(World& world, const glm::ivec2& chunkPos) {
+    regenerated.clear();
+    for (int dz = -1; dz <= 1; dz++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            const uint32_t slot =
+                world.chunks.findSlot(chunkPos.x + dx, chunkPos.y + dz);
+            if ((dx || dz) && slot != ChunkMap::NO_SLOT &&
+                world.chunks[slot].state != ChunkState::QUEUED &&
+                !world.chunks[slot].data.hasBlocks())
+                regenerated.push_back(slot);
+            neighbourhood[dz + 1][dx + 1] =
+                world.getChunk(chunkPos.x + dx, chunkPos.y + dz);
         }
-        if (chunkChanged) {
-            glm::ivec2 newChunkCoords = chunkPos + chunkChanges[f];
-            Chunk* nextChunk =
-                world.getChunk(newChunkCoords.x, newChunkCoords.y);
-            if (!nextChunk ||
-                !nextChunk->getBlocks().containsBlock(adjacentPos)) {
-                res[f] = true;
-            }
-        } else {
-            advanceInDirection(static_cast<Facing>(f), adjacentPos);
-            if (!chunkData.containsBlock(adjacentPos)) res[f] = true;
+    }
+    const auto around = [](const int dz, const int dx) -> const ChunkData& {
+        return neighbourhood[dz][dx]->getBlocks();
+    };
+
+    const auto row = [](const ChunkData& data, const int y, const int z) {
+        uint32_t bits = 0;
+        const BlockType* blocks = &data.getBlock({0, y, z});
+        for (int x = 0; x < Chunk::WIDTH; x++)
+            bits |= uint32_t(isOpaque(blocks[x])) << x;
+        return bits;
+    };
+
+    // blocks light passes through, but which are still drawn
+    const ChunkData& centre = around(1, 1);
+    for (int y = 0; y < Chunk::HEIGHT; y++) {
+        for (int z = 0; z < Chunk::DEPTH; z++) {
+            uint32_t bits = 0;
+            const BlockType* blocks = &centre.getBlock({0, y, z});
+            for (int x = 0; x < Chunk::WIDTH; x++)
+                bits |= uint32_t(blocks[x] != BlockType::AIR &&
+                                 !isOpaque(blocks[x])) << x;
+            looseBlocks[y * Chunk::DEPTH + z] = bits;
         }
     }
 
-    // check y+ and y-
-    for (int f = 4; f < 6; f++) {
-        auto adjacentPos = blockPos;
-        if (adjacentPos[affectedCoords[f]] == extremePoses[f]) {
-            res[f] = true;
-            continue;
+    // rows below and above the chunk stay empty
+    std::fill(occupancy.begin(), occupancy.end(), 0);
+    for (int y = 0; y < Chunk::HEIGHT; y++) {
+        for (int z = -1; z <= Chunk::DEPTH; z++) {
+            const int dz = z < 0 ? 0 : z < Chunk::DEPTH ? 1 : 2;
+            const int localZ = (z + Chunk::DEPTH) % Chunk::DEPTH;
+            uint64_t bits = uint64_t(row(around(dz, 1), y, localZ)) << 1;
+            bits |= uint64_t(row(around(dz, 0), y, localZ) >> (Chunk::WIDTH - 1));
+            bits |= uint64_t(row(around(dz, 2), y, localZ) & 1) << (Chunk::WIDTH + 1);
+            occupancyRow(y, z) = bits;
         }
-        advanceInDirection(static_cast<Facing>(f), adjacentPos);
-        if (!chunkData.containsBlock(adjacentPos)) res[f] = true;
     }
+}
 
-    return res;
+// Corner occlusion of the face of block pos, packed as cornerAO expects.
+// Counts solid blocks next to the corner in the layer the face looks at
+unsigned ChunkMesher::faceAO(const glm::ivec3& pos, const int facing) {
+    const auto [axis1, axis2, fixedAxis] = axisMap[facing];
+    glm::ivec3 plane = pos;
+    advanceInDirection(static_cast<Facing>(facing), plane);
+
+    unsigned ao = 0;
+    for (int c2 = 0; c2 < 2; c2++) {
+        for (int c1 = 0; c1 < 2; c1++) {
+            glm::ivec3 side1 = plane, side2 = plane;
+            side1[axis1] += c1 ? 1 : -1;
+            side2[axis2] += c2 ? 1 : -1;
+            glm::ivec3 corner = side1;
+            corner[axis2] = side2[axis2];
+
+            const unsigned s1 = isOccupied(side1), s2 = isOccupied(side2);
+            const unsigned occlusion =
+                s1 && s2 ? 3 : s1 + s2 + isOccupied(corner);
+            ao |= occlusion << (2 * (c1 + 2 * c2));
+        }
+    }
+    return ao;
+}
+
+// Packed light of the block at pos, which may lie in a neighbour chunk
+uint8_t ChunkMesher::lightAt(glm::ivec3 pos) {
+    if (pos.y >= Chunk::HEIGHT) return ChunkLight::FULL_SKY;
+    if (pos.y < 0) return 0;
+    const int dx = pos.x < 0 ? -1 : pos.x >= Chunk::WIDTH ? 1 : 0;
+    const int dz = pos.z < 0 ? -1 : pos.z >= Chunk::DEPTH ? 1 : 0;
+    pos.x -= dx * Chunk::WIDTH;
+    pos.z -= dz * Chunk::DEPTH;
+    return neighbourhood[dz + 1][dx + 1]->light.get(pos);
 }
 
 glm::ivec3 posFromHash32(short hash) {
@@ -66,23 +136,19 @@ glm::ivec3 posFromHash32(short hash) {
 
 short hashFromPos(const glm::ivec3& pos) { return ChunkData::getIndex(pos); }
 
-void ChunkMesher::greedyMesh() {
+void ChunkMesher::greedyMesh(const int size, const uint8_t sections) {
     // Clear previous data
     for (auto& faces : greedChunkFaces)
         for (auto& dir : faces) dir.clear();
+    for (auto& bounds : greedBounds) bounds.fill({});
 
-    // Define plane axes and fixed axis for each facing
-    static constexpr std::tuple<int, int, int> axisMap[6] = {
-        {2, 1, 0},  // LEFT:   plane axes Z(axis1) and Y(axis2), fixed X
-        {2, 1, 0},  // RIGHT:  plane axes Z(axis1) and Y(axis2), fixed X
-        {0, 1, 2},  // FRONT:  plane axes X(axis1) and Y(axis2), fixed Z
-        {0, 1, 2},  // BACK:   plane axes X(axis1) and Y(axis2), fixed Z
-        {0, 2, 1},  // TOP:    plane axes X(axis1) and Z(axis2), fixed Y
-        {0, 2, 1}   // BOTTOM: plane axes X(axis1) and Z(axis2), fixed Y
-    };
+    // LOD cells are scaled up to full blocks in the shader
+    const float scale = static_cast<float>(Chunk::WIDTH / size);
 
     for (int subChunk = 0; subChunk < Chunk::SUB_COUNT; subChunk++) {
-        for (int facing = 0; facing < 6; facing++) {
+        if (!(sections & 1 << subChunk)) continue;
+        for (int group = 0; group < FACE_GROUPS; group++) {
+            const int facing = group % 6;
             // Extract axes configuration
             const auto& axes = axisMap[facing];
             const int axis1 = std::get<0>(axes);      // First plane axis
@@ -90,11 +156,11 @@ void ChunkMesher::greedyMesh() {
             const int fixedAxis = std::get<2>(axes);  // Fixed axis
 
             // Iterate through all possible fixed axis positions
-            for (int fixedVal = 0; fixedVal < Chunk::WIDTH; fixedVal++) {
+            for (int fixedVal = 0; fixedVal < size; fixedVal++) {
                 for (auto&& i : processed) i = false;
 
-                for (int a2 = 0; a2 < Chunk::WIDTH; a2++) {
-                    for (int a1 = 0; a1 < Chunk::WIDTH; a1++) {
+                for (int a2 = 0; a2 < size; a2++) {
+                    for (int a1 = 0; a1 < size; a1++) {
                         // Create position vector with fixed axis value
                         glm::ivec3 pos(0);
                         pos[axis1] = a1;
@@ -106,34 +172,37 @@ void ChunkMesher::greedyMesh() {
 
                         // Skip if already processed or no face
                         if (processed[idx] ||
-                            !chunkFaces[subChunk][facing].contains(hashPos))
+                            !chunkFaces[subChunk][group].contains(hashPos))
                             continue;
 
-                        const unsigned layer =
-                            chunkFaces[subChunk][facing][hashPos];
+                        const unsigned value =
+                            chunkFaces[subChunk][group][hashPos];
+                        const unsigned layer = value & ((1 << AO_SHIFT) - 1);
+                        const unsigned ao = (value >> AO_SHIFT) & 0xFF;
                         int width = 1;
                         int height = 1;
 
                         // Find maximum width (along axis1)
-                        for (int w = a1 + 1; w < Chunk::WIDTH; w++) {
+                        for (int w = a1 + 1;
+                             w < size && uniformAlongAxis1(ao); w++) {
                             glm::ivec3 testPos = pos;
                             testPos[axis1] = w;
                             const short testHash = hashFromPos(testPos);
                             const size_t testIdx = w + a2 * Chunk::WIDTH;
 
                             if (processed[testIdx] ||
-                                !chunkFaces[subChunk][facing].contains(
+                                !chunkFaces[subChunk][group].contains(
                                     testHash) ||
-                                chunkFaces[subChunk][facing][testHash] !=
-                                    layer) {
+                                chunkFaces[subChunk][group][testHash] !=
+                                    value) {
                                 break;
                             }
                             width++;
                         }
 
                         // Find maximum height (along axis2)
-                        bool heightValid = true;
-                        for (int h = a2 + 1; h < Chunk::WIDTH; h++) {
+                        bool heightValid = uniformAlongAxis2(ao);
+                        for (int h = a2 + 1; h < size && heightValid; h++) {
                             for (int w = a1; w < a1 + width; w++) {
                                 glm::ivec3 testPos = pos;
                                 testPos[axis1] = w;
@@ -142,10 +211,10 @@ void ChunkMesher::greedyMesh() {
                                 const size_t testIdx = w + h * Chunk::WIDTH;
 
                                 if (processed[testIdx] ||
-                                    !chunkFaces[subChunk][facing].contains(
+                                    !chunkFaces[subChunk][group].contains(
                                         testHash) ||
-                                    chunkFaces[subChunk][facing][testHash] !=
-                                        layer) {
+                                    chunkFaces[subChunk][group][testHash] !=
+                                        value) {
                                     heightValid = false;
                                     break;
                                 }
@@ -172,83 +241,258 @@ void ChunkMesher::greedyMesh() {
                         size[axis1] = width;
                         size[axis2] = height;
 
+                        FaceMesh face = CubeModel::getFace(
+                            static_cast<Facing>(facing), actualPos, layer,
+                            size, glm::ivec2{size[axis1], size[axis2]});
+                        applyLighting(face, actualPos, facing, ao,
+                                      value >> LIGHT_SHIFT);
+
                         // Add merged face
-                        greedChunkFaces[subChunk][facing].emplace_back(
-                            CubeModel::getFace(
-                                static_cast<Facing>(facing), actualPos, layer,
-                                size, glm::ivec2{size[axis1], size[axis2]}));
+                        auto& faces = greedChunkFaces[subChunk][group];
+                        auto& bounds = greedBounds[subChunk][group];
+                        if (faces.empty())
+                            bounds = {glm::vec3(Chunk::WIDTH), glm::vec3(0)};
+                        for (const auto& vertex : face.vertices) {
+                            const glm::vec3 v = glm::vec3(vertex.getX(),
+                                                          vertex.getY(),
+                                                          vertex.getZ()) *
+                                                scale;
+                            bounds.min = glm::min(bounds.min, v);
+                            bounds.max = glm::max(bounds.max, v);
+                        }
+                        faces.emplace_back(face);
                     }
                 }
             }
         }
     }
 }
-void ChunkMesher::generateChunkMesh(const glm::ivec2& chunkPos,
-                                    GPU::MappedChunkBuffer& pool) {
+void ChunkMesher::generateChunkMesh(const uint32_t slot,
+                                    GPU::MappedChunkBuffer& pool,
+                                    const size_t sectionSlack) {
     size_t total_size = 0;
 
-    std::array<std::array<GPU::MappedChunkBuffer::GPUBufferView, 6>,
-               Chunk::SUB_COUNT>
-        subChunks{};
+    GPU::MappedChunkBuffer::ChunkBufferView subChunks{};
 
     for (int subChunkY = 0; subChunkY < Chunk::SUB_COUNT; subChunkY++) {
-        for (int facing = 0; facing < 6; facing++) {
-            subChunks[subChunkY][facing].size =
-                greedChunkFaces[subChunkY][facing].size();
-            subChunks[subChunkY][facing].offset = total_size;
-            total_size += greedChunkFaces[subChunkY][facing].size();
+        for (int group = 0; group < FACE_GROUPS; group++) {
+            subChunks[subChunkY][group].size =
+                greedChunkFaces[subChunkY][group].size();
+            subChunks[subChunkY][group].offset = total_size;
+            subChunks[subChunkY][group].bounds =
+                greedBounds[subChunkY][group];
+            total_size += greedChunkFaces[subChunkY][group].size();
         }
+        // face groups of a section stay contiguous, so slack goes after them
+        total_size += sectionSlack;
     }
 
-    const size_t chunkID = Chunk::getId(chunkPos.x, chunkPos.y);
-
-    auto gpuBuffer = pool.getAllocation(chunkID);
+    auto gpuBuffer = pool.getAllocation(slot);
     if (gpuBuffer.is_free)
-        gpuBuffer = pool.allocate(chunkID, total_size * sizeof(FaceMesh));
+        gpuBuffer = pool.allocate(slot, total_size * sizeof(FaceMesh));
 
-    pool.resizeAllocation(chunkID, total_size * sizeof(FaceMesh));
+    pool.resizeAllocation(slot, total_size * sizeof(FaceMesh));
 
     for (int subChunk = 0; subChunk < Chunk::SUB_COUNT; subChunk++) {
-        for (int facing = 0; facing < 6; facing++) {
-            pool.write(chunkID, greedChunkFaces[subChunk][facing].data(),
-                       subChunks[subChunk][facing].size * sizeof(FaceMesh),
-                       subChunks[subChunk][facing].offset * sizeof(FaceMesh));
+        for (int group = 0; group < FACE_GROUPS; group++) {
+            pool.write(slot, greedChunkFaces[subChunk][group].data(),
+                       subChunks[subChunk][group].size * sizeof(FaceMesh),
+                       subChunks[subChunk][group].offset * sizeof(FaceMesh));
         }
     }
 
-    pool.chunkViewData[chunkID] = subChunks;
+    pool.chunkViewData[slot] = subChunks;
+
+    pool.sync();
+}
+
+// Rewrites given sections inside their current ranges of the allocation.
+// Returns false if a section no longer fits, whole mesh has to be rebuilt then
+bool ChunkMesher::writeSections(const uint32_t slot,
+                                GPU::MappedChunkBuffer& pool,
+                                const uint8_t sections) {
+    const auto allocation = pool.getAllocation(slot);
+    if (allocation.is_free) return false;
+    auto& view = pool.chunkViewData[slot];
+
+    // section range ends where next section starts
+    const auto sectionEnd = [&](const int subChunk) {
+        return subChunk + 1 < Chunk::SUB_COUNT
+                   ? view[subChunk + 1][0].offset
+                   : allocation.size / sizeof(FaceMesh);
+    };
+
+    for (int subChunk = 0; subChunk < Chunk::SUB_COUNT; subChunk++) {
+        if (!(sections & 1 << subChunk)) continue;
+        size_t size = 0;
+        for (int group = 0; group < FACE_GROUPS; group++)
+            size += greedChunkFaces[subChunk][group].size();
+        if (view[subChunk][0].offset + size > sectionEnd(subChunk))
+            return false;
+    }
+
+    for (int subChunk = 0; subChunk < Chunk::SUB_COUNT; subChunk++) {
+        if (!(sections & 1 << subChunk)) continue;
+        size_t offset = view[subChunk][0].offset;
+        for (int group = 0; group < FACE_GROUPS; group++) {
+            auto& faces = greedChunkFaces[subChunk][group];
+            pool.write(slot, faces.data(),
+                       faces.size() * sizeof(FaceMesh),
+                       offset * sizeof(FaceMesh));
+            view[subChunk][group] = {offset, faces.size(),
+                                     greedBounds[subChunk][group]};
+            offset += faces.size();
+        }
+    }
 
     pool.sync();
+    return true;
 }
 
 void ChunkMesher::generateChunkMeshData(World& world,
-                                        const glm::ivec2& chunkPos) {
+                                        const glm::ivec2& chunkPos,
+                                        const uint8_t sections) {
     // clear all previous data
     for (auto& subChunk : chunkFaces)
         for (auto& dir : subChunk) dir.clear();
 
-    Chunk* chunk = world.getChunk(chunkPos.x, chunkPos.y);
-    if (!chunk) return;
-    const ChunkData& chunkData = chunk->getBlocks();
+    buildOccupancy(world, chunkPos);
 
+    // faces are found a whole row at a time, by masking occupancy with
+    // occupancy shifted one block towards the facing
+    constexpr uint64_t inside = ((uint64_t(1) << Chunk::WIDTH) - 1) << 1;
+    const ChunkData& data = neighbourhood[1][1]->getBlocks();
     for (int y = 0; y < Chunk::HEIGHT; y++) {
         int subChunkY = y / Chunk::SUB_HEIGHT;
+        if (!(sections & 1 << subChunkY)) {
+            y += Chunk::SUB_HEIGHT - 1;
+            continue;
+        }
         for (int z = 0; z < Chunk::DEPTH; z++) {
-            for (int x = 0; x < Chunk::WIDTH; x++) {
-                if (!chunkData.containsBlock({x, y, z})) continue;
-                const int layer = 0;
-                glm::ivec3 blockPos{x, y, z};
+            addLooseFaces(data, y, z);
+            const uint64_t blocks = occupancyRow(y, z);
+            if (!(blocks & inside)) continue;
+
+            const uint64_t faceRows[6] = {
+                blocks & ~(blocks << 1),           // WEST
+                blocks & ~(blocks >> 1),           // EAST
+                blocks & ~occupancyRow(y, z - 1),  // SOUTH
+                blocks & ~occupancyRow(y, z + 1),  // NORTH
+                blocks & ~occupancyRow(y + 1, z),  // UP
+                blocks & ~occupancyRow(y - 1, z),  // DOWN
+            };
+
+            for (int f = 0; f < 6; f++) {
+                for (uint64_t bits = faceRows[f] & inside; bits;
+                     bits &= bits - 1) {
+                    const int x = std::countr_zero(bits) - 1;
+                    const unsigned layer = getTextureLayer(
+                        data.getBlock({x, y, z}), static_cast<Facing>(f));
+                    const unsigned ao = faceAO({x, y, z}, f);
+                    glm::ivec3 facingPos{x, y, z};
+                    advanceInDirection(static_cast<Facing>(f), facingPos);
+                    const unsigned light = lightAt(facingPos);
+
+                    // block pos in subchunk for correct mesh generation
+                    chunkFaces[subChunkY][f][hashFromPos(
+                        {x, y % Chunk::SUB_HEIGHT, z})] =
+                        layer | ao << AO_SHIFT | light << LIGHT_SHIFT;
+                }
+            }
+        }
+    }
+
+    // faces are found, neighbours drawn from their pyramid need no blocks again
+    for (const uint32_t slot : regenerated) world.dropBlocks(slot);
+}
 
-                std::array<bool, 6> res =
-                    checkAdjacentBlocks(world, chunkData, chunkPos, blockPos);
+// Block at pos, which may lie in a neighbour chunk
+BlockType ChunkMesher::blockAt(glm::ivec3 pos) {
+    if (pos.y < 0 || pos.y >= Chunk::HEIGHT) return BlockType::AIR;
+    const int dx = pos.x < 0 ? -1 : pos.x >= Chunk::WIDTH ? 1 : 0;
+    const int dz = pos.z < 0 ? -1 : pos.z >= Chunk::DEPTH ? 1 : 0;
+    pos.x -= dx * Chunk::WIDTH;
+    pos.z -= dz * Chunk::DEPTH;
+    return neighbourhood[dz + 1][dx + 1]->getBlocks().getBlock(pos);
+}
 
-                // block pos in subchunk for correct mesh generation
-                blockPos.y %= Chunk::SUB_HEIGHT;
+// Faces of blocks light passes through in row (y, z), into the range of
+// their render layer. They are rare, so they are meshed one by one. Faces
+// between blocks of the same type are hidden, so water or a glass wall shows
+// no faces inside
+void ChunkMesher::addLooseFaces(const ChunkData& data, const int y,
+                                const int z) {
+    const int subChunkY = y / Chunk::SUB_HEIGHT;
+    for (uint32_t bits = looseBlocks[y * Chunk::DEPTH + z]; bits;
+         bits &= bits - 1) {
+        const int x = std::countr_zero(bits);
+        const BlockType type = data.getBlock({x, y, z});
+        const RenderLayer layer = getRenderLayer(type);
+        for (int f = 0; f < 6; f++) {
+            glm::ivec3 facingPos{x, y, z};
+            advanceInDirection(static_cast<Facing>(f), facingPos);
+            const BlockType other = blockAt(facingPos);
+            if (other == type || isOpaque(other)) continue;
+
+            chunkFaces[subChunkY][GPU::MappedChunkBuffer::faceGroup(layer, f)]
+                      [hashFromPos({x, y % Chunk::SUB_HEIGHT, z})] =
+                getTextureLayer(type, static_cast<Facing>(f)) |
+                faceAO({x, y, z}, f) << AO_SHIFT |
+                lightAt(facingPos) << LIGHT_SHIFT;
+        }
+    }
+}
+
+// Writes corner occlusion and light into vertices of the face merged at pos.
+// Quad is split along the diagonal with more occlusion, so it shades
+// symmetrically
+void ChunkMesher::applyLighting(FaceMesh& face, const glm::ivec3& pos,
+                                const int facing, const unsigned ao,
+                                const unsigned light) {
+    const auto [axis1, axis2, fixedAxis] = axisMap[facing];
+    for (auto& vertex : face.vertices) {
+        const glm::ivec3 v(vertex.getX(), vertex.getY(), vertex.getZ());
+        vertex.setAO(cornerAO(ao, v[axis1] > pos[axis1], v[axis2] > pos[axis2]));
+        vertex.setLight(light);
+    }
+    if (!ao) return;
+
+    // vertices are v0 v1 v2, v2 v3 v0
+    auto& vs = face.vertices;
+    if (vs[1].getAO() + vs[4].getAO() > vs[0].getAO() + vs[2].getAO())
+        vs = {vs[1], vs[2], vs[4], vs[4], vs[0], vs[1]};
+}
+
+void ChunkMesher::generateLODMeshData(const LowDetailChunkData& data) {
+    // clear all previous data
+    for (auto& subChunk : chunkFaces)
+        for (auto& dir : subChunk) dir.clear();
+
+    // sub chunks keep world-space size, so they just hold fewer cells
+    const int subHeight = data.height / Chunk::SUB_COUNT;
+
+    for (int y = 0; y < data.height; y++) {
+        int subChunkY = y / subHeight;
+        for (int z = 0; z < data.depth; z++) {
+            for (int x = 0; x < data.width; x++) {
+                if (!data.containsBlock({x, y, z})) continue;
+                const glm::ivec3 blockPos{x, y, z};
+                const BlockType type = data.data[data.getID(blockPos)];
 
                 for (int f = 0; f < 6; f++) {
-                    if (res[f])
-                        chunkFaces[subChunkY][f][chunkData.getIndex(blockPos)] =
-                            layer;
+                    glm::ivec3 adjacentPos = blockPos;
+                    advanceInDirection(static_cast<Facing>(f), adjacentPos);
+                    // Everything outside the chunk counts as air, so border
+                    // faces are always emitted. They work as skirts covering
+                    // cracks against neighbours meshed at another LOD level
+                    if (data.isInside(adjacentPos) &&
+                        data.containsBlock(adjacentPos))
+                        continue;
+                    // LOD meshes are far away in open terrain, so lit by sky
+                    chunkFaces[subChunkY][f][hashFromPos(
+                        {x, y % subHeight, z})] =
+                        getTextureLayer(type, static_cast<Facing>(f)) |
+                        ChunkLight::FULL_SKY << LIGHT_SHIFT;
                 }
             }
         }
@@ -306,9 +550,71 @@ void greedyMeshPlane(
     }
 }
 
+// Fits chunk box around its mesh in y, terrain fills columns in x and z
+void ChunkMesher::updateChunkBounds(Chunk& chunk,
+                                    const GPU::MappedChunkBuffer& pool,
+                                    const uint32_t slot) {
+    float minY = Chunk::HEIGHT, maxY = 0;
+    for (int subChunk = 0; subChunk < Chunk::SUB_COUNT; subChunk++) {
+        for (const auto& facing : pool.chunkViewData[slot][subChunk]) {
+            if (!facing.size) continue;
+            minY = std::min(minY, subChunk * Chunk::SUB_HEIGHT + facing.bounds.min.y);
+            maxY = std::max(maxY, subChunk * Chunk::SUB_HEIGHT + facing.bounds.max.y);
+        }
+    }
+    chunk.setHeightRange(std::min(minY, maxY), maxY);
+}
+
 void ChunkMesher::update(World& world, const glm::ivec2& chunkPos,
                          GPU::MappedChunkBuffer& pool) {
+    const uint32_t slot = world.getSlot(chunkPos.x, chunkPos.y);
     generateChunkMeshData(world, chunkPos);
-    greedyMesh();
-    generateChunkMesh(chunkPos, pool);
+    greedyMesh(Chunk::WIDTH);
+    generateChunkMesh(slot, pool, SECTION_SLACK);
+    updateChunkBounds(world.chunks[slot], pool, slot);
+    world.chunks[slot].data.updateSolidHeight();
+    world.chunks[slot].data.updateVisibility(ChunkData::ALL_SECTIONS);
+    world.chunks[slot].data.clearDirty();
+    world.chunks[slot].state = ChunkState::UPLOADED;
+}
+
+void ChunkMesher::updateDirty(World& world, const glm::ivec2& chunkPos,
+                              GPU::MappedChunkBuffer& pool) {
+    const uint32_t slot = world.getSlot(chunkPos.x, chunkPos.y);
+    const uint8_t sections = world.chunks[slot].data.dirtySections;
+    if (!sections) return;
+
+    generateChunkMeshData(world, chunkPos, sections);
+    greedyMesh(Chunk::WIDTH, sections);
+    if (!writeSections(slot, pool, sections)) {
+        update(world, chunkPos, pool);
+        return;
+    }
+    updateChunkBounds(world.chunks[slot], pool, slot);
+    world.chunks[slot].data.updateSolidHeight();
+    world.chunks[slot].data.updateVisibility(sections);
+    world.chunks[slot].data.clearDirty();
+}
+
+void ChunkMesher::updateLOD(World& world, const glm::ivec2& chunkPos,
+                            GPU::MappedChunkBuffer& pool, const int LOD) {
+    // blocks are generated again only when the pyramid has to be rebuilt
+    const LowDetailChunk* chunk =
+        world.getLowDetailChunk(chunkPos.x, chunkPos.y, LOD);
+    const uint32_t slot = world.chunks.findSlot(chunkPos.x, chunkPos.y);
+    generateLODMeshData(chunk->getBlocks());
+    greedyMesh(Chunk::WIDTH >> LOD);
+    generateChunkMesh(slot, pool);
+    updateChunkBounds(world.chunks[slot], pool, slot);
+    // dropped blocks were not edited since, so what was found before
+    // dropping them still holds
+    ChunkData& data = world.chunks[slot].data;
+    if (data.hasBlocks()) {
+        data.updateSolidHeight();
+        data.updateVisibility(ChunkData::ALL_SECTIONS);
+    }
+    data.clearDirty();
+    world.chunks[slot].state = ChunkState::UPLOADED;
+    // drawn from the pyramid only until it comes closer or is edited
+    world.dropBlocks(slot);
 }
@@ -9,28 +9,80 @@
 #include "render/renderers/block/CubeModel.h"
 
 class ChunkMesher {
+    static constexpr int FACE_GROUPS = GPU::MappedChunkBuffer::FACE_GROUPS;
+
+    // faces of every section by face group, see MappedChunkBuffer::faceGroup
     static inline std::array<
-        std::array<std::unordered_map<short, unsigned int>, 6>,
+        std::array<std::unordered_map<short, unsigned int>, FACE_GROUPS>,
         Chunk::SUB_COUNT>
         chunkFaces;
-    static inline std::array<std::array<std::vector<FaceMesh>, 6>,
+    static inline std::array<std::array<std::vector<FaceMesh>, FACE_GROUPS>,
                              Chunk::SUB_COUNT>
         greedChunkFaces;
+    // bounds of greedChunkFaces, in blocks of full detail
+    static inline std::array<std::array<AABB, FACE_GROUPS>, Chunk::SUB_COUNT>
+        greedBounds;
     static inline std::vector<bool> processed =
         std::vector<bool>(Chunk::WIDTH * Chunk::WIDTH, false);
 
-    static std::array<bool, 6> checkAdjacentBlocks(World& world,
-                                                   const ChunkData& chunkData,
-                                                   const glm::ivec2& chunkPos,
-                                                   const glm::ivec3& blockPos);
-    static void generateChunkMeshData(World& world, const glm::ivec2& chunkPos);
-    static void generateChunkMesh(const glm::ivec2& chunkPos,
-                                  GPU::MappedChunkBuffer& pool);
-    static void greedyMesh();
+    // Occupancy of the meshed chunk padded by one block from every side, bit
+    // x + 1 of row (y, z) is set if block (x, y, z) is solid. Used for face
+    // culling and ambient occlusion alike
+    static constexpr int OCCUPANCY_ROWS = Chunk::DEPTH + 2;
+    static inline std::vector<uint64_t> occupancy =
+        std::vector<uint64_t>((Chunk::HEIGHT + 2) * OCCUPANCY_ROWS, 0);
+
+    static uint64_t& occupancyRow(const int y, const int z) {
+        return occupancy[(y + 1) * OCCUPANCY_ROWS + z + 1];
+    }
+    static bool isOccupied(const glm::ivec3& pos) {
+        return occupancyRow(pos.y, pos.z) >> (pos.x + 1) & 1;
+    }
+
+    // meshed chunk and its neighbours, [dz + 1][dx + 1]
+    static inline const Chunk* neighbourhood[3][3];
+    // neighbours drawn from their LOD pyramid, whose dropped blocks were
+    // generated again for this mesh only
+    static inline std::vector<uint32_t> regenerated;
+
+    // Blocks of the meshed chunk which are drawn but are not opaque, bit x of
+    // row y * DEPTH + z. They are not in occupancy and get faces of their own
+    static inline std::vector<uint32_t> looseBlocks =
+        std::vector<uint32_t>(Chunk::HEIGHT * Chunk::DEPTH, 0);
+
+    static void buildOccupancy(World& world, const glm::ivec2& chunkPos);
+    static unsigned faceAO(const glm::ivec3& pos, int facing);
+    static uint8_t lightAt(glm::ivec3 pos);
+    static BlockType blockAt(glm::ivec3 pos);
+    static void addLooseFaces(const ChunkData& data, int y, int z);
+    static void applyLighting(FaceMesh& face, const glm::ivec3& pos,
+                              int facing, unsigned ao, unsigned light);
+    // Faces reserved after every section of full LOD 0 mesh, so edited
+    // sections can usually be rewritten in place
+    static constexpr size_t SECTION_SLACK = 32;
+
+    static void generateChunkMeshData(
+        World& world, const glm::ivec2& chunkPos,
+        uint8_t sections = ChunkData::ALL_SECTIONS);
+    static void generateLODMeshData(const LowDetailChunkData& data);
+    static void generateChunkMesh(uint32_t slot, GPU::MappedChunkBuffer& pool,
+                                  size_t sectionSlack = 0);
+    static bool writeSections(uint32_t slot, GPU::MappedChunkBuffer& pool,
+                              uint8_t sections);
+    static void greedyMesh(int size,
+                           uint8_t sections = ChunkData::ALL_SECTIONS);
+    static void updateChunkBounds(Chunk& chunk,
+                                  const GPU::MappedChunkBuffer& pool,
+                                  uint32_t slot);
 
    public:
     static void update(World& world, const glm::ivec2& chunkPos,
                        GPU::MappedChunkBuffer& pool);
+    // Remeshes only dirty sections of uploaded LOD 0 chunk
+    static void updateDirty(World& world, const glm::ivec2& chunkPos,
+                            GPU::MappedChunkBuffer& pool);
+    static void updateLOD(World& world, const glm::ivec2& chunkPos,
+                          GPU::MappedChunkBuffer& pool, int LOD);
 };
 
 #endif  // CHUNKMESHER_H
@@ -0,0 +1,103 @@
+#include "ChunkResidency.hpp"
+
+void ChunkResidency::update(World& world, const glm::ivec2& origin, const int size) {
+    grid.update(origin, size, [this, &world](int x, int z, uint32_t slot) {
+        // cell is empty if chunk was generated only as a mesher neighbour
+        if (slot == ChunkMap::NO_SLOT) slot = world.chunks.findSlot(x, z);
+        if (slot == ChunkMap::NO_SLOT) return;
+        makeEvictable(world, slot);
+    });
+}
+
+uint32_t ChunkResidency::acquire(World& world, const int x, const int z) {
+    uint32_t& slot = grid.at(x, z);
+    // chunk which left the window may still be loaded as evictable
+    if (slot == ChunkMap::NO_SLOT) slot = world.reserveSlot(x, z);
+    if (world.chunks[slot].state == ChunkState::EVICTABLE) revive(world, slot);
+    return slot;
+}
+
+void ChunkResidency::release(World& world, const int x, const int z) {
+    const uint32_t slot = grid.at(x, z);
+    if (slot == ChunkMap::NO_SLOT) return;
+    makeEvictable(world, slot);
+}
+
+void ChunkResidency::releaseMesh(World& world, const uint32_t slot) {
+    Record& record = (*this)[slot];
+    if (record.LOD == -1) return;
+    pool->deallocate(slot);
+    record.LOD = -1;
+    revision++;
+
+    Chunk& chunk = world.chunks[slot];
+    if (chunk.state == ChunkState::UPLOADED) chunk.state = ChunkState::GENERATED;
+}
+
+void ChunkResidency::enforceBudget(World& world) {
+    while (evictableBytes > EVICTABLE_MEMORY_BUDGET && lruHead != ChunkMap::NO_SLOT) {
+        evict(world, lruHead);
+    }
+}
+
+void ChunkResidency::makeEvictable(World& world, const uint32_t slot) {
+    Chunk& chunk = world.chunks[slot];
+    if (chunk.state == ChunkState::EVICTABLE) return;
+    if (chunk.state == ChunkState::QUEUED) {
+        // never generated, nothing worth keeping
+        evict(world, slot);
+        return;
+    }
+
+    Record& record = (*this)[slot];
+    record.resumeState = chunk.state;
+    // chunks drawn from their LOD pyramid hold it instead of blocks, the mesh is of any LOD
+    record.bytes = chunk.data.blocks.size() * sizeof(BlockType) + chunk.light.getMemory() +
+                   world.getLODMemory(slot) + pool->getAllocation(slot).size;
+    chunk.state = ChunkState::EVICTABLE;
+    revision++;
+
+    record.prev = lruTail;
+    record.next = ChunkMap::NO_SLOT;
+    if (lruTail != ChunkMap::NO_SLOT) records[lruTail].next = slot;
+    else lruHead = slot;
+    lruTail = slot;
+
+    evictableBytes += record.bytes;
+}
+
+void ChunkResidency::revive(World& world, const uint32_t slot) {
+    Record& record = (*this)[slot];
+    unlink(slot);
+    world.chunks[slot].state = record.resumeState;
+    revision++;
+
+    stats.regenerationsAvoided++;
+    if (record.resumeState == ChunkState::UPLOADED) stats.remeshesAvoided++;
+}
+
+void ChunkResidency::evict(World& world, const uint32_t slot) {
+    Chunk& chunk = world.chunks[slot];
+    if (chunk.state == ChunkState::EVICTABLE) unlink(slot);
+    releaseMesh(world, slot);
+
+    if (grid.contains(chunk.xCoord, chunk.zCoord) && grid.at(chunk.xCoord, chunk.zCoord) == slot)
+        grid.at(chunk.xCoord, chunk.zCoord) = ChunkMap::NO_SLOT;
+
+    world.unloadChunk(slot);
+    (*this)[slot] = {};
+    stats.evicted++;
+}
+
+void ChunkResidency::unlink(const uint32_t slot) {
+    Record& record = records[slot];
+    if (record.prev != ChunkMap::NO_SLOT) records[record.prev].next = record.next;
+    else lruHead = record.next;
+    if (record.next != ChunkMap::NO_SLOT) records[record.next].prev = record.prev;
+    else lruTail = record.prev;
+
+    record.prev = ChunkMap::NO_SLOT;
+    record.next = ChunkMap::NO_SLOT;
+    evictableBytes -= record.bytes;
+    record.bytes = 0;
+}
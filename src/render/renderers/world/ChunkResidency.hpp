@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "game/world/ChunkGrid.hpp"
+#include "game/world/World.h"
+#include "render/buffers/MappedBufferPool.h"
+
+// Decides which chunks stay loaded around the camera and drives their ChunkState.
+// Chunks are drawn inside view radius, keep whatever they have up to EVICT_MARGIN chunks further
+// and become EVICTABLE past it. Evictable chunks stay loaded (with their mesh) in LRU order until
+// memory budget is exceeded, so a camera hovering around a border does not regenerate and remesh them
+class ChunkResidency {
+public:
+    // Width of hysteresis band (in chunks) past view distance
+    static constexpr int EVICT_MARGIN = 2;
+    // Memory evictable chunks may hold (blocks, light, LOD pyramid and mesh) before least recently
+    // used are unloaded
+    static constexpr size_t EVICTABLE_MEMORY_BUDGET = 256ull * 1024 * 1024;
+
+    struct Stats {
+        uint64_t evicted = 0;
+        // evictable chunks brought back to view without generating them again
+        uint64_t regenerationsAvoided = 0;
+        // of those, chunks which still had their mesh uploaded
+        uint64_t remeshesAvoided = 0;
+    };
+
+    struct Record {
+        // LOD level of the chunk mesh, -1 if there is no mesh
+        int LOD = -1;
+        // state to return to when evictable chunk comes back to view
+        ChunkState resumeState = ChunkState::QUEUED;
+        size_t bytes = 0;
+        uint32_t prev = ChunkMap::NO_SLOT;
+        uint32_t next = ChunkMap::NO_SLOT;
+    };
+
+    void init(GPU::MappedChunkBuffer* pool) { this->pool = pool; }
+
+    // Slides residency window, chunks leaving it become evictable
+    void update(World& world, const glm::ivec2& origin, int size);
+
+    // Slot of the chunk in view range. Reserves QUEUED chunk or brings evictable chunk back
+    uint32_t acquire(World& world, int x, int z);
+
+    // Chunk at (x, z) is past the hysteresis band
+    void release(World& world, int x, int z);
+
+    // Frees GPU mesh of the chunk, chunk goes back to GENERATED
+    void releaseMesh(World& world, uint32_t slot);
+
+    // Unloads least recently used evictable chunks until they fit into memory budget
+    void enforceBudget(World& world);
+
+    Record& operator[](uint32_t slot) {
+        if (slot >= records.size()) records.resize(slot + 1);
+        return records[slot];
+    }
+
+    const Stats& getStats() const { return stats; }
+    size_t getEvictableMemory() const { return evictableBytes; }
+    // Changes every time a chunk changes state or loses its mesh here
+    uint64_t getRevision() const { return revision; }
+
+private:
+    GPU::MappedChunkBuffer* pool = nullptr;
+    ChunkGrid grid;
+    std::vector<Record> records;
+
+    // LRU list of evictable chunks, head is the oldest one
+    uint32_t lruHead = ChunkMap::NO_SLOT;
+    uint32_t lruTail = ChunkMap::NO_SLOT;
+    size_t evictableBytes = 0;
+    uint64_t revision = 0;
+
+    Stats stats;
+
+    void makeEvictable(World& world, uint32_t slot);
+    void revive(World& world, uint32_t slot);
+    void evict(World& world, uint32_t slot);
+    void unlink(uint32_t slot);
+};
@@ -1,8 +1,14 @@
 #include "QuadRenderer.hpp"
 
+#include <cstddef>
 #include <glm/ext/matrix_transform.hpp>
 
 #include "game/data_loaders/globals.h"
+#include "render/utils/FrameUniforms.h"
+
+// attributes 6 and 7 read neighbouring fields together
+static_assert(offsetof(Quad, period) == offsetof(Quad, velocity) + sizeof(glm::vec3));
+static_assert(offsetof(Quad, twinkle) == offsetof(Quad, phase) + 2 * sizeof(float));
 
 void QuadRenderer::init(const std::string& atlas) {
     quadShader = new Shader("shaders/quad/vert.glsl", "shaders/quad/frag.glsl");
@@ -33,90 +39,51 @@ void QuadRenderer::init(const std::string& atlas) {
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
     glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    const auto instanceAttribute = [](const GLuint index, const GLint size, const size_t offset) {
+        glEnableVertexAttribArray(index);
+        glVertexAttribPointer(index, size, GL_FLOAT, GL_FALSE, sizeof(Quad), reinterpret_cast<void*>(offset));
+        glVertexAttribDivisor(index, 1);
+    };
+    instanceAttribute(1, 3, offsetof(Quad, position));
+    instanceAttribute(2, 1, offsetof(Quad, scale));
+    instanceAttribute(3, 1, offsetof(Quad, size));
+    instanceAttribute(4, 2, offsetof(Quad, uvStart));
+    instanceAttribute(5, 4, offsetof(Quad, color));
+    // velocity and period
+    instanceAttribute(6, 4, offsetof(Quad, velocity));
+    // phase, growth and twinkle
+    instanceAttribute(7, 3, offsetof(Quad, phase));
+
+    quadShader->bindUniformBlock(FrameUniforms::BLOCK_NAME, FrameUniforms::BINDING);
+    skyRotationUniform = quadShader->getUniform<glm::mat4>("uSkyRotation");
+    timeUniform = quadShader->getUniform<float>("uTime");
+    opacityUniform = quadShader->getUniform<float>("uOpacity");
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
-
-void QuadRenderer::addQuads(int count, const glm::vec2& uvStart, float scale, float size) {
-    quads.reserve(count);
-    for (int i = 0; i < count; ++i) {
-        float theta = rand() * 2 * M_PI / RAND_MAX;
-        float phi = acos(2.0f * rand() / RAND_MAX - 1.0f);
-        const int radius = 64;
-        quads.push_back({
-                glm::vec3(sin(phi) * cos(theta) * radius, cos(phi) * radius, sin(phi) * sin(theta) * radius),
-                scale, size / 64.0f, uvStart / 64.0f
-            });
-    }
-
-    // Instance VBO
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(Quad) * quads.size(), quads.data(), GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Quad), (void*)0);
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(Quad), (void*)12);
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Quad), (void*)16);
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(Quad), (void*)20);
-    glVertexAttribDivisor(1, 1);
-    glVertexAttribDivisor(2, 1);
-    glVertexAttribDivisor(3, 1);
-    glVertexAttribDivisor(4, 1);
-}
-
-void QuadRenderer::addQuad(const glm::vec2& start, float scale, float size, const glm::vec3& pos) {
-    quads.push_back({
-            pos,
-            scale, size / 64.0f, start / 64.0f
-        });
-
-    // Instance VBO
+void QuadRenderer::upload() {
     glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(Quad) * quads.size(), quads.data(), GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Quad), (void*)0);
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(Quad), (void*)12);
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Quad), (void*)16);
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(Quad), (void*)20);
-    glVertexAttribDivisor(1, 1);
-    glVertexAttribDivisor(2, 1);
-    glVertexAttribDivisor(3, 1);
-    glVertexAttribDivisor(4, 1);
+    instanceCount = static_cast<GLsizei>(quads.size());
+    quads = {};
 }
 
-
-void QuadRenderer::render(const glm::mat4& view, const glm::mat4& proj, const Camera& camera,
-                          float rotation, float opacity) const {
-    // glDisable(GL_DEPTH_TEST);
-
+void QuadRenderer::render(const float rotation, const float opacity, const float time) const {
+    if (!instanceCount) return;
     quadShader->use();
 
-    glm::mat4 skyRotation = glm::rotate(glm::mat4(1.0f), rotation, {0, 0, 1});
-    // glm::mat4 model = glm::mat4(1.0f);
-
-    quadShader->setMat4("uMVP", proj * glm::mat4(glm::mat3(view)));
-    quadShader->setMat4("uSkyRotation", skyRotation);
-    quadShader->setVec3("uCameraRight", camera.getRight());
-    quadShader->setVec3("uCameraUp", camera.getUp());
-    quadShader->setVec3("uCameraPos", camera.getPosition());
-    quadShader->setFloat("uOpacity", opacity);
+    skyRotationUniform.set(glm::rotate(glm::mat4(1.0f), rotation, {0, 0, 1}));
+    timeUniform.set(time);
+    opacityUniform.set(opacity);
+    glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D, atlasTexture);
 
-    // Single draw call for all celestial bodies
+    // Single draw call for all quads
     glBindVertexArray(quadVAO);
-    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, quads.size());
-
-    // glDisable(GL_BLEND);
-    // glEnable(GL_DEPTH_TEST);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, instanceCount);
 }
 
 QuadRenderer::~QuadRenderer() {
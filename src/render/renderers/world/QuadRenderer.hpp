@@ -1,28 +1,46 @@
 #pragma once
-#include "render/Camera.h"
+#include <vector>
+
 #include "render/utils/Shader.h"
 
+// Instance of a camera facing quad in the sky, at most 64 blocks from the camera.
+// Animation is computed in the vertex shader from time alone
 struct Quad {
     glm::vec3 position;
     float scale;
-    float size;
-    glm::vec2 uvStart;
+    float size;         // texels of atlas the quad shows, divided by atlas size
+    glm::vec2 uvStart;  // divided by atlas size
+    glm::vec4 color{1.0f};   // multiplies texture, alpha included
+    glm::vec3 velocity{0.0f}; // blocks per second, quad starts over every period
+    float period = 0;         // seconds, 0 keeps quad in place
+    float phase = 0;          // seconds the animation is ahead of time
+    float growth = 0;         // scale gained over one period
+    float twinkle = 0;        // 0..1, how deep brightness flickers
 };
 
+// Draws all quads added before upload in one instanced call. Instances are uploaded once,
+// frames set only time, sky rotation and opacity
 class QuadRenderer {
 
     Shader* quadShader = nullptr;
     GLuint quadVAO = 0, instanceVBO = 0, quadVBO = 0;
     std::vector<Quad> quads;
+    GLsizei instanceCount = 0;
     GLuint atlasTexture = 0;
 
+    Uniform<glm::mat4> skyRotationUniform;
+    Uniform<float> timeUniform;
+    Uniform<float> opacityUniform;
+
 public:
     void init(const std::string& atlas);
 
-    void render(const glm::mat4& view, const glm::mat4& proj, const Camera& camera, float rotation, float opacity) const;
+    // Quads wait on CPU until upload
+    void addQuad(const Quad& quad) { quads.push_back(quad); }
+    void upload();
 
-    void addQuads(int count, const glm::vec2& start, float scale, float size);
-    void addQuad(const glm::vec2& start, float scale, float size, const glm::vec3& pos);
+    // rotation turns quads around z axis, time in seconds
+    void render(float rotation, float opacity, float time) const;
 
     ~QuadRenderer();
 };
@@ -3,7 +3,11 @@
 #include <glm/gtc/constants.hpp>
 #include <SDL3/SDL_timer.h>
 
+#include <cstdint>
+#include <random>
+
 #include "game/data_loaders/globals.h"
+#include "render/utils/FrameUniforms.h"
 
 static constexpr float skyboxVertices[108] = {
         // positions
@@ -50,17 +54,103 @@ static constexpr float skyboxVertices[108] = {
         1.0f, -1.0f, 1.0f
     };
 
+namespace {
+    // distance of sky quads from camera
+    constexpr float SKY_RADIUS = 64;
+    // the same seeds place everything at the same spot on every run
+    constexpr uint32_t STAR_SEED = 1;
+    constexpr uint32_t CLOUD_SEED = 2;
+    constexpr uint32_t SMOKE_SEED = 3;
+
+    // [0, 1) from the raw generator output, the same with every standard library
+    float unit(std::mt19937& rng) {
+        return static_cast<float>(rng() >> 8) / (1 << 24);
+    }
+
+    float spread(std::mt19937& rng, const float min, const float max) {
+        return min + unit(rng) * (max - min);
+    }
+
+    Quad atlasQuad(const glm::vec2& start, const float scale, const float size, const glm::vec3& pos) {
+        return {pos, scale, size / 64.0f, start / 64.0f};
+    }
+
+    glm::vec3 skyPoint(const float azimuth, const float elevation) {
+        return glm::vec3(cosf(elevation) * cosf(azimuth), sinf(elevation),
+                         cosf(elevation) * sinf(azimuth)) * SKY_RADIUS;
+    }
+
+    // Stars spread evenly over the whole sphere
+    void addStars(QuadRenderer& renderer, std::mt19937& rng, const int count, const glm::vec2& start,
+                  const float scale, const float size) {
+        for (int i = 0; i < count; i++) {
+            const float azimuth = unit(rng) * 2 * glm::pi<float>();
+            const float elevation = asinf(2 * unit(rng) - 1);
+            Quad star = atlasQuad(start, scale, size, skyPoint(azimuth, elevation));
+            star.phase = unit(rng) * 100;
+            star.twinkle = spread(rng, 0.1f, 0.6f);
+            renderer.addQuad(star);
+        }
+    }
+
+    // Flat band of clouds low above the horizon, drifting along it
+    void addClouds(QuadRenderer& renderer, std::mt19937& rng, const int count) {
+        for (int i = 0; i < count; i++) {
+            const float azimuth = unit(rng) * 2 * glm::pi<float>();
+            Quad cloud = atlasQuad({32, 0}, spread(rng, 2, 5), 8, skyPoint(azimuth, spread(rng, 0.1f, 0.45f)));
+            cloud.color = {1, 1, 1, spread(rng, 0.3f, 0.6f)};
+            cloud.velocity = glm::vec3(-sinf(azimuth), 0, cosf(azimuth)) * 0.3f;
+            cloud.period = spread(rng, 60, 120);
+            cloud.phase = unit(rng) * cloud.period;
+            cloud.growth = 1;
+            renderer.addQuad(cloud);
+        }
+    }
+
+    // Columns of smoke puffs rising from chimneys on the horizon
+    void addSmoke(QuadRenderer& renderer, std::mt19937& rng, const int chimneys, const int puffs) {
+        constexpr float PERIOD = 12;
+        for (int c = 0; c < chimneys; c++) {
+            const glm::vec3 base = skyPoint(unit(rng) * 2 * glm::pi<float>(), 0.0f);
+            const glm::vec3 wind = glm::vec3(spread(rng, -0.3f, 0.3f), 1.2f, spread(rng, -0.3f, 0.3f));
+            for (int i = 0; i < puffs; i++) {
+                Quad puff = atlasQuad({32, 0}, 0.4f, 8, base);
+                const float grey = spread(rng, 0.3f, 0.5f);
+                puff.color = {grey, grey, grey, 0.7f};
+                puff.velocity = wind;
+                puff.period = PERIOD;
+                // puffs spread evenly over the loop, column is never empty
+                puff.phase = (i + unit(rng)) * PERIOD / puffs;
+                puff.growth = 2.5f;
+                renderer.addQuad(puff);
+            }
+        }
+    }
+}
+
 void SkyRenderer::init() {
+    std::mt19937 starRng(STAR_SEED);
     nightSkyRenderer.init("assets/sky/sky.png");
-    nightSkyRenderer.addQuads(100, {44, 0}, 0.1, 2.0); //100 small stars
-    nightSkyRenderer.addQuads(30, {40, 0}, 0.15, 4.0); //30 medium stars
-    nightSkyRenderer.addQuads(7, {32, 0}, 0.2, 8.0); //7 big stars
-    nightSkyRenderer.addQuad({0, 32}, 3, 32.0, {-100, 0, 0}); //moon
+    addStars(nightSkyRenderer, starRng, 3000, {44, 0}, 0.1, 2.0);
+    addStars(nightSkyRenderer, starRng, 400, {40, 0}, 0.15, 4.0);
+    addStars(nightSkyRenderer, starRng, 40, {32, 0}, 0.2, 8.0);
+    nightSkyRenderer.addQuad(atlasQuad({0, 32}, 3, 32.0, {-100, 0, 0})); //moon
+    nightSkyRenderer.upload();
 
     sunRenderer.init("assets/sky/sky.png");
-    sunRenderer.addQuad({0, 0}, 6, 32.0, {100, 0, 0}); //sun
+    sunRenderer.addQuad(atlasQuad({0, 0}, 6, 32.0, {100, 0, 0})); //sun
+    sunRenderer.upload();
+
+    // clouds and smoke stay put while the sky turns
+    std::mt19937 cloudRng(CLOUD_SEED);
+    std::mt19937 smokeRng(SMOKE_SEED);
+    weatherRenderer.init("assets/sky/sky.png");
+    addClouds(weatherRenderer, cloudRng, 600);
+    addSmoke(weatherRenderer, smokeRng, 4, 48);
+    weatherRenderer.upload();
 
     skyboxShader = new Shader("shaders/skybox/vert.glsl", "shaders/skybox/frag.glsl");
+    skyboxShader->bindUniformBlock(FrameUniforms::BLOCK_NAME, FrameUniforms::BINDING);
     glGenVertexArrays(1, &skyVAO);
     glBindVertexArray(skyVAO);
     glGenBuffers(1, &skyVBO);
@@ -71,7 +161,7 @@ void SkyRenderer::init() {
     startTime = SDL_GetTicks();
 }
 
-void SkyRenderer::renderSkybox(const glm::mat4& view, const glm::mat4& proj, const Camera& camera) const {
+void SkyRenderer::renderSkybox() const {
     if (!skyboxShader) return;
     float currentTime = SDL_GetTicks();
     float elapsed = currentTime - startTime; //ms
@@ -94,14 +184,15 @@ void SkyRenderer::renderSkybox(const glm::mat4& view, const glm::mat4& proj, con
 
     skyboxShader->setFloat("uTime", t);
     skyboxShader->setVec3("uSunDirection", sunDir);
-    skyboxShader->setMat4("uView", view);
-    skyboxShader->setMat4("uProjection", proj);
 
     glBindVertexArray(skyVAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
 
-    nightSkyRenderer.render(view, proj, camera, angle, std::max(0.0f, -sinf(angle)));
-    sunRenderer.render(view, proj, camera, angle, 1);
+    const float seconds = elapsed / 1000.0f;
+    nightSkyRenderer.render(angle, std::max(0.0f, -sinf(angle)), seconds);
+    sunRenderer.render(angle, 1, seconds);
+    // darker at night
+    weatherRenderer.render(0, 0.3f + 0.7f * std::max(0.0f, sinf(angle)), seconds);
 
     glDepthMask(GL_TRUE);
     glEnable(GL_CULL_FACE);
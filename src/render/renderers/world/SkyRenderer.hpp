@@ -10,11 +10,12 @@ class SkyRenderer {
 
     QuadRenderer nightSkyRenderer;
     QuadRenderer sunRenderer;
+    QuadRenderer weatherRenderer;
 
     float startTime = 0;
 
 public:
-    void renderSkybox(const glm::mat4& view, const glm::mat4& proj, const Camera& camera) const;
+    void renderSkybox() const;
     void init();
     ~SkyRenderer();
 };
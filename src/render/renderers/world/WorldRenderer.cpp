@@ -2,54 +2,118 @@
 
 #include <SDL3/SDL_timer.h>
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <iostream>
-#include <unordered_set>
+#include <optional>
 
 #include "ChunkMesher.h"
 #include "game/data_loaders/globals.h"
+#include "render/globals.h"
 #include "render/renderers/block/CubeModel.h"
 #include "render/utils.h"
+#include "utils/ParallelFor.hpp"
+#include "utils/RadixSort.hpp"
+
+// Box around the mesh of section, none when the section has no faces
+std::optional<AABB> getSubChunkBoundingBox(
+    const GPU::MappedChunkBuffer::ChunkBufferView& view,
+    const glm::ivec3& coords) {
+    std::optional<AABB> box;
+    for (const auto& facing : view[coords.y]) {
+        if (!facing.size) continue;
+        if (!box) box = facing.bounds;
+        box->min = glm::min(box->min, facing.bounds.min);
+        box->max = glm::max(box->max, facing.bounds.max);
+    }
+    if (!box) return box;
+    const glm::vec3 origin(coords.x * Chunk::WIDTH, coords.y * Chunk::SUB_HEIGHT,
+                           coords.z * Chunk::DEPTH);
+    return AABB{origin + box->min, origin + box->max};
+}
+
+// How many chunk centres inside box are within distance from camera
+Containment radiusContainment(const AABB& box, const glm::vec3& camera,
+                              const float distance) {
+    const float x0 = box.min.x + Chunk::WIDTH / 2.0f, x1 = box.max.x - Chunk::WIDTH / 2.0f;
+    const float z0 = box.min.z + Chunk::DEPTH / 2.0f, z1 = box.max.z - Chunk::DEPTH / 2.0f;
+    const float nearX = std::clamp(camera.x, x0, x1) - camera.x;
+    const float nearZ = std::clamp(camera.z, z0, z1) - camera.z;
+    if (nearX * nearX + nearZ * nearZ > distance * distance)
+        return Containment::OUTSIDE;
+    const float farX = std::max(std::abs(x0 - camera.x), std::abs(x1 - camera.x));
+    const float farZ = std::max(std::abs(z0 - camera.z), std::abs(z1 - camera.z));
+    return farX * farX + farZ * farZ > distance * distance ? Containment::PARTIAL
+                                                           : Containment::INSIDE;
+}
 
-AABB getSubChunkBoundingBox(const glm::vec3& chunkPosition) {
-    AABB box{};
-    box.min = chunkPosition;
-    box.max = chunkPosition +
-              glm::vec3(Chunk::WIDTH, Chunk::SUB_HEIGHT, Chunk::DEPTH);
-    return box;
+// LOD ring the distance (in chunks) falls into
+int getLODRing(const float distance) {
+    int LOD = 0;
+    for (float ring = LOD_DISTANCE; distance >= ring && LOD < LOD_LEVELS;
+         ring *= 2)
+        LOD++;
+    return LOD;
+}
+
+// Keeps previous LOD until camera is far enough past the ring border
+int selectLOD(const float distance, const int previous) {
+    if (previous < 0) return getLODRing(distance);
+    if (const int LOD = getLODRing(distance - LOD_HYSTERESIS); LOD > previous)
+        return LOD;
+    if (const int LOD = getLODRing(distance + LOD_HYSTERESIS); LOD < previous)
+        return LOD;
+    return previous;
 }
 
 void WorldRenderer::init() {
     bufferPool = new GPU::MappedChunkBuffer();
-
-    shader = new Shader("shaders/face/vert.glsl", "shaders/face/frag.glsl",
-                        "shaders/face/geom.glsl");
-    shader->use();
+    frameUniforms.init();
+    residency.init(bufferPool);
+
+    const auto loadFaceProgram = [](const char* fragPath) {
+        FaceProgram faceProgram;
+        faceProgram.shader = new Shader("shaders/face/vert.glsl", fragPath,
+                                        "shaders/face/geom.glsl");
+        faceProgram.shader->use();
+        faceProgram.shader->bindUniformBlock(FrameUniforms::BLOCK_NAME,
+                                             FrameUniforms::BINDING);
+        faceProgram.chunkCoords =
+            faceProgram.shader->getUniform<glm::ivec3>("chunkCoords");
+        faceProgram.lodScale = faceProgram.shader->getUniform<float>("lodScale");
+        faceProgram.shader->setSampler("atlasTexture", 0);
+        return faceProgram;
+    };
+    opaqueProgram = loadFaceProgram("shaders/face/frag.glsl");
+    alphaProgram = loadFaceProgram("shaders/face/alpha_frag.glsl");
+    alphaCutoffUniform = alphaProgram.shader->getUniform<float>("alphaCutoff");
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D_ARRAY, textureManager.getTextureArray());
-    shader->setSampler("atlasTexture", 0);
 
     glGenVertexArrays(1, &VAO);
 
     glBindVertexArray(VAO);
 
     glGenBuffers(1, &indirectBuffer);
+    glGenQueries(OVERDRAW_QUERIES, overdrawQueries.data());
 
     skyRenderer.init();
 
-    cmds.reserve(4 * Chunk::SUB_COUNT);
 }
 
-void WorldRenderer::renderSubChunkFacing(
-    const GPU::MappedChunkBuffer::ChunkBufferView& view, int y, Facing f,
-    size_t vertexOffset, std::vector<DrawArraysIndirectCommand>& cmds) {
-    const auto size = view[y][f].size * 6;
-    const auto offset = view[y][f].offset * 6 + vertexOffset;
+void WorldRenderer::recordSubChunkFacing(
+    const GPU::MappedChunkBuffer::ChunkBufferView& view, int y, int group,
+    size_t vertexOffset, size_t firstCommand,
+    std::vector<DrawArraysIndirectCommand>& cmds) {
+    const auto size = view[y][group].size * 6;
+    const auto offset = view[y][group].offset * 6 + vertexOffset;
     if (size > 0) {
-        if (!cmds.empty()) {
+        // commands of other sub chunks are drawn with other uniforms
+        if (cmds.size() > firstCommand) {
             auto& lastCMD = cmds.back();
             if (lastCMD.first + lastCMD.count == offset) {
                 // increase last cmd count
@@ -61,84 +125,313 @@ void WorldRenderer::renderSubChunkFacing(
     }
 }
 
-void WorldRenderer::renderSubChunk(
-    const glm::ivec3& coords, const glm::vec3& cameraCoords, size_t offset,
-    const GPU::MappedChunkBuffer::ChunkBufferView& buffer) {
-    cmds.clear();
+void WorldRenderer::recordSubChunk(const SectionDraw& section,
+                                   const RenderLayer layer,
+                                   const glm::vec3& cameraCoords,
+                                   CommandList& list) {
+    auto& cmds = list.cmds;
+    const size_t first = cmds.size();
+    const glm::ivec3& coords = section.coords;
+    const auto& buffer = bufferPool->chunkViewData[section.slot];
+    const size_t offset =
+        bufferPool->getAllocation(section.slot).offset / sizeof(Vertex);
+
+    // faces of a facing group are seen only from in front of the farthest
+    // back one of them
+    const glm::vec3 camera =
+        cameraCoords - glm::vec3(coords.x * Chunk::WIDTH,
+                                 coords.y * Chunk::SUB_HEIGHT,
+                                 coords.z * Chunk::DEPTH);
+    const int base = GPU::MappedChunkBuffer::faceGroup(layer, 0);
+    const auto* facings = &buffer[coords.y][base];
+    const auto record = [&](const Facing f) {
+        recordSubChunkFacing(buffer, coords.y, base + f, offset, first, cmds);
+    };
+
+    if (camera.x > facings[EAST].bounds.min.x) record(EAST);
+    if (camera.x < facings[WEST].bounds.max.x) record(WEST);
+
+    if (camera.y > facings[UP].bounds.min.y) record(UP);
+    if (camera.y < facings[DOWN].bounds.max.y) record(DOWN);
+
+    if (camera.z > facings[NORTH].bounds.min.z) record(NORTH);
+    if (camera.z < facings[SOUTH].bounds.max.z) record(SOUTH);
+
+    if (cmds.size() == first) return;
+    list.batches[static_cast<int>(layer)].push_back(
+        {coords, section.LOD, static_cast<uint32_t>(first),
+         static_cast<uint32_t>(cmds.size() - first)});
+}
 
-    if (coords.x * Chunk::WIDTH - static_cast<int>(cameraCoords.x) <
-        Chunk::WIDTH)
-        renderSubChunkFacing(buffer, coords.y, EAST, offset, cmds);
-    if (static_cast<int>(cameraCoords.x) - coords.x * Chunk::WIDTH <
-        Chunk::WIDTH)
-        renderSubChunkFacing(buffer, coords.y, WEST, offset, cmds);
+// Exact culling of a tile of collected chunks for the current camera
+void WorldRenderer::cullTile(const size_t tile, const glm::vec3& camera,
+                             const float drawRadius) {
+    auto& sections = tileSections[tile];
+    sections.clear();
+    const size_t end = std::min(draws.size(), (tile + 1) * COLUMNS_PER_TILE);
+    for (size_t i = tile * COLUMNS_PER_TILE; i < end; i++) {
+        const ChunkDraw& draw = draws[i];
+        const glm::vec3 center((draw.coords.x + 0.5f) * Chunk::WIDTH, 0,
+                               (draw.coords.y + 0.5f) * Chunk::DEPTH);
+        const glm::vec2 offset(center.x - camera.x, center.z - camera.z);
+        if (glm::dot(offset, offset) > drawRadius * drawRadius) continue;
+
+        // whole sections passed the batched test, boxes around their faces are tighter
+        const uint8_t visible = draw.sections & frustumSections[i];
+        const auto& view = bufferPool->chunkViewData[draw.slot];
+        for (int y = 0; y < Chunk::SUB_COUNT; y++) {
+            if (!(visible & 1 << y)) continue;
+            const glm::ivec3 coords(draw.coords.x, y, draw.coords.y);
+            const AABB box = *getSubChunkBoundingBox(view, coords);
+            if (frustumCuller.classify(box) == Containment::OUTSIDE ||
+                !occlusionCuller.isVisible(box))
+                continue;
+            const glm::vec3 sectionCenter =
+                (glm::vec3(coords) + 0.5f) *
+                glm::vec3(Chunk::WIDTH, Chunk::SUB_HEIGHT, Chunk::DEPTH);
+            sections.push_back(
+                {static_cast<uint32_t>(glm::length(sectionCenter - camera) *
+                                       DISTANCE_STEPS),
+                 draw.slot, coords, draw.LOD});
+        }
+    }
+}
 
-    if (coords.y * Chunk::SUB_HEIGHT - static_cast<int>(cameraCoords.y) <
-        Chunk::SUB_HEIGHT)
-        renderSubChunkFacing(buffer, coords.y, UP, offset, cmds);
-    if (static_cast<int>(cameraCoords.y) - coords.y * Chunk::SUB_HEIGHT <
-        Chunk::SUB_HEIGHT)
-        renderSubChunkFacing(buffer, coords.y, DOWN, offset, cmds);
+// Records commands of a range of sorted sections. Depth test rejects most
+// hidden fragments when opaque faces are drawn near to far, translucent ones
+// blend correctly only far to near
+void WorldRenderer::recordCommandList(const size_t index,
+                                      const glm::vec3& camera) {
+    CommandList& list = commandLists[index];
+    list.cmds.clear();
+    for (auto& layerBatches : list.batches) layerBatches.clear();
+
+    const size_t first = index * SECTIONS_PER_LIST;
+    const size_t last = std::min(sectionDraws.size(), first + SECTIONS_PER_LIST);
+    for (size_t i = 0; i < last - first; i++) {
+        const auto& section = sectionDraws[frontToBack ? first + i : last - 1 - i];
+        recordSubChunk(section, RenderLayer::OPAQUE, camera, list);
+        recordSubChunk(section, RenderLayer::CUTOUT, camera, list);
+    }
+    for (size_t i = last; i-- > first;)
+        recordSubChunk(sectionDraws[i], RenderLayer::TRANSLUCENT, camera, list);
+}
 
-    if (coords.z * Chunk::DEPTH - static_cast<int>(cameraCoords.z) <
-        Chunk::DEPTH)
-        renderSubChunkFacing(buffer, coords.y, NORTH, offset, cmds);
-    if (static_cast<int>(cameraCoords.z) - coords.z * Chunk::DEPTH <
-        Chunk::DEPTH)
-        renderSubChunkFacing(buffer, coords.y, SOUTH, offset, cmds);
+// Chunks which may be visible from anywhere in the camera cell and
+// orientation bucket of the draw list cache
+void WorldRenderer::collectDraws(const World& world, const Camera& camera,
+                                 const float drawRadius) {
+    draws.clear();
+    const float margin = DrawListCache::positionMargin();
+    const Frustum frustum =
+        camera.getFrustum(DrawListCache::angleMargin(), margin);
+
+    caveCuller.update(world, camera.Position, frustum, drawRadius + margin);
+
+    // regions out of range or out of frustum are dropped at once
+    frustumCuller.setFrustum(frustum);
+    world.tree.query(
+        [&](const AABB& box) {
+            return std::min(
+                radiusContainment(box, camera.Position, drawRadius + margin),
+                frustumCuller.classify(box));
+        },
+        [&](const glm::ivec2& coords, const uint32_t slot, const int height,
+            const Containment containment) {
+            if (world.chunks[slot].state != ChunkState::UPLOADED) return;
+            uint8_t sections = containment == Containment::INSIDE
+                                   ? ChunkData::ALL_SECTIONS
+                                   : frustumCuller.testSections(coords);
+            // sections above the highest block are empty
+            sections &= (1 << (height + Chunk::SUB_HEIGHT - 1) / Chunk::SUB_HEIGHT) - 1;
+            sections &= caveCuller.getSections(slot);
+            // sections are tested again with boxes around their faces only
+            for (int y = 0; y < Chunk::SUB_COUNT; y++) {
+                if (!(sections & 1 << y)) continue;
+                const auto box = getSubChunkBoundingBox(
+                    bufferPool->chunkViewData[slot], {coords.x, y, coords.y});
+                if (!box || (containment != Containment::INSIDE &&
+                             frustumCuller.classify(*box) == Containment::OUTSIDE))
+                    sections &= ~(1 << y);
+            }
+            if (sections)
+                draws.push_back({slot, coords, residency[slot].LOD, sections});
+        });
+}
 
-    if (cmds.empty()) return;
+// Exact culling of collected chunks for the current camera, records their
+// indirect commands
+void WorldRenderer::buildDrawList(const World& world, const Camera& camera,
+                                  const Frustum& frustum,
+                                  const float drawRadius) {
+    // solid floors of chunks close by hide what is behind them, chunks waiting
+    // for remesh may have holes in them already
+    occluders.clear();
+    world.tree.query(
+        [&](const AABB& box) {
+            return radiusContainment(box, camera.Position,
+                                     OCCLUDER_DISTANCE * Chunk::WIDTH);
+        },
+        [&](const glm::ivec2& coords, const uint32_t slot, int, Containment) {
+            const Chunk& chunk = world.chunks[slot];
+            if (chunk.state != ChunkState::UPLOADED || residency[slot].LOD != 0 ||
+                chunk.data.dirtySections || chunk.data.solidHeight == 0)
+                return;
+            occluders.push_back(
+                {glm::vec3(coords.x * Chunk::WIDTH, 0, coords.y * Chunk::DEPTH),
+                 glm::vec3((coords.x + 1) * Chunk::WIDTH, chunk.data.solidHeight,
+                           (coords.y + 1) * Chunk::DEPTH)});
+        });
+
+    occlusionCuller.begin(
+        camera.getProjectionMatrix() * camera.getViewMatrix(), camera.Position);
+    for (const auto& box : occluders) occlusionCuller.addOccluder(box);
+    occlusionCuller.finish();
+
+    // draws come in quadtree order, so tiles of them are neighbouring columns
+    // and regions of the batched frustum test
+    frustumCuller.setFrustum(frustum);
+    drawColumns.clear();
+    for (const ChunkDraw& draw : draws) drawColumns.push_back(draw.coords);
+    frustumSections.resize(draws.size());
+    frustumCuller.cull(drawColumns, frustumSections);
+
+    const size_t tileCount =
+        (draws.size() + COLUMNS_PER_TILE - 1) / COLUMNS_PER_TILE;
+    if (tileSections.size() < tileCount) tileSections.resize(tileCount);
+    parallelFor(tileCount, [&](const size_t tile) {
+        cullTile(tile, camera.Position, drawRadius);
+    });
+
+    sectionDraws.clear();
+    for (size_t tile = 0; tile < tileCount; tile++)
+        sectionDraws.insert(sectionDraws.end(), tileSections[tile].begin(),
+                            tileSections[tile].end());
+    radixSort(sectionDraws, sortScratch,
+              [](const SectionDraw& section) { return section.distance; });
+
+    const size_t listCount =
+        (sectionDraws.size() + SECTIONS_PER_LIST - 1) / SECTIONS_PER_LIST;
+    if (commandLists.size() < listCount) commandLists.resize(listCount);
+    parallelFor(listCount, [&](const size_t list) {
+        recordCommandList(list, camera.Position);
+    });
 
-    shader->setIVec3("chunkCoords", coords);
+    // one prefix sum over command counts places every list in the indirect
+    // buffer, batches are merged in drawing order of their layer
+    size_t commandCount = 0;
+    for (size_t list = 0; list < listCount; list++) {
+        commandLists[list].base = commandCount;
+        commandCount += commandLists[list].cmds.size();
+    }
+    for (int layer = 0; layer < RENDER_LAYERS; layer++) {
+        const bool nearToFar =
+            frontToBack && layer != static_cast<int>(RenderLayer::TRANSLUCENT);
+        auto& layerBatches = batches[layer];
+        layerBatches.clear();
+        for (size_t i = 0; i < listCount; i++) {
+            const CommandList& list = commandLists[nearToFar ? i : listCount - 1 - i];
+            for (SubChunkBatch batch : list.batches[layer]) {
+                batch.firstCommand += static_cast<uint32_t>(list.base);
+                layerBatches.push_back(batch);
+            }
+        }
+    }
 
     glBufferData(GL_DRAW_INDIRECT_BUFFER,
-                 sizeof(DrawArraysIndirectCommand) * cmds.size(), cmds.data(),
+                 sizeof(DrawArraysIndirectCommand) * commandCount, nullptr,
                  GL_DYNAMIC_DRAW);
-    glMultiDrawArraysIndirect(GL_TRIANGLES, nullptr, cmds.size(), 0);
+    for (size_t list = 0; list < listCount; list++)
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER,
+                        sizeof(DrawArraysIndirectCommand) * commandLists[list].base,
+                        sizeof(DrawArraysIndirectCommand) * commandLists[list].cmds.size(),
+                        commandLists[list].cmds.data());
 }
 
-void WorldRenderer::renderChunk(
-    const size_t id, const glm::ivec2& coords, const size_t y0, const size_t y1,
-    const glm::vec3& cameraCoords,
-    const GPU::MappedChunkBuffer::ChunkBufferView& buffer) {
-    if (buffer.back().back().offset - buffer.front().front().offset == 0)
-        return;
-
+// Draws recorded sub chunks layer by layer, commands stay in the indirect
+// buffer until the draw list is rebuilt
+void WorldRenderer::submitDrawList() {
     if (auto err = glGetError(); err != GL_NO_ERROR)
         std::cout << __FILE__ << ':' << __LINE__ << ' ' << err << std::endl;
 
-    if (y0 == -1) return;
-    for (int y = y0; y <= y1; y++) {
-        // std::cout << "Rendering subchunk " << coords.x << ' ' << y << ' ' <<
-        // coords.y << std::endl;
-        renderSubChunk({coords.x, y, coords.y}, cameraCoords,
-                       bufferPool->getAllocation(id).offset / sizeof(Vertex),
-                       buffer);
+    const auto& opaque = batches[static_cast<int>(RenderLayer::OPAQUE)];
+    const auto& cutout = batches[static_cast<int>(RenderLayer::CUTOUT)];
+    const auto& translucent =
+        batches[static_cast<int>(RenderLayer::TRANSLUCENT)];
+
+    // query of this slot from OVERDRAW_QUERIES frames ago is reused
+    const GLuint query = overdrawQueries[overdrawFrame % OVERDRAW_QUERIES];
+    if (overdrawFrame++ >= OVERDRAW_QUERIES) readOverdrawQuery(query);
+
+    glBeginQuery(GL_SAMPLES_PASSED, query);
+    glDisable(GL_BLEND);
+    useProgram(opaqueProgram);
+    submitBatches(opaque);
+
+    if (!cutout.empty() || !translucent.empty()) useProgram(alphaProgram);
+    if (!cutout.empty()) {
+        alphaCutoffUniform.set(0.5f);
+        submitBatches(cutout);
+    }
+    glEndQuery(GL_SAMPLES_PASSED);
+
+    // translucent faces do not hide each other, only what is behind them
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (!translucent.empty()) {
+        alphaCutoffUniform.set(0.0f);
+        glDepthMask(GL_FALSE);
+        submitBatches(translucent);
+        glDepthMask(GL_TRUE);
     }
 
     if (auto err = glGetError(); err != GL_NO_ERROR)
         std::cout << __FILE__ << ':' << __LINE__ << ' ' << err << std::endl;
+}
 
-    // buffer->notifySubmitted();
+// Counts fragments of an earlier frame, skipped when the GPU is still behind
+void WorldRenderer::readOverdrawQuery(const GLuint query) {
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return;
+    GLuint64 fragments = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &fragments);
+    overdrawStats.fragments += fragments;
+    overdrawStats.pixels +=
+        static_cast<uint64_t>(render::screenWidth) * render::screenHeight;
+}
+
+void WorldRenderer::submitBatches(
+    const std::vector<SubChunkBatch>& layerBatches) {
+    for (const auto& batch : layerBatches) {
+        setLOD(batch.LOD);
+        program->chunkCoords.set(batch.coords);
+        glMultiDrawArraysIndirect(
+            GL_TRIANGLES,
+            reinterpret_cast<const void*>(batch.firstCommand *
+                                          sizeof(DrawArraysIndirectCommand)),
+            batch.commandCount, 0);
+    }
+}
+
+void WorldRenderer::useProgram(const FaceProgram& faceProgram) {
+    program = &faceProgram;
+    faceProgram.shader->use();
+    currentLOD = -1;
 }
 
 void WorldRenderer::renderChunkGrid(const Camera& camera) {}
 
+void WorldRenderer::setLOD(const int LOD) {
+    if (LOD == currentLOD) return;
+    currentLOD = LOD;
+    program->lodScale.set(static_cast<float>(1 << LOD));
+}
+
 int WorldRenderer::render(World& world, const Camera& camera) {
     const auto& view = camera.getViewMatrix();
     const auto& proj = camera.getProjectionMatrix();
 
-    skyRenderer.renderSkybox(view, proj, camera);
-
-    if (renderWireframe)
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    else
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-    shader->use();
-    shader->setMat4("view", view);
-    shader->setMat4("projection", proj);
-
     auto time = SDL_GetTicks();
     float radius = 50.0f;   // distance from center
     float height = 100.0f;  // height above ground
@@ -147,32 +440,45 @@ int WorldRenderer::render(World& world, const Camera& camera) {
     float lightX = cosf(angle) * radius;
     float lightZ = sinf(angle) * radius;
     float lightY = height;  // fixed height
-    shader->setVec3("lightDir",
-                    glm::normalize(glm::vec3(lightX, lightY, lightZ)));
+    frameUniforms.update(
+        {view, proj, proj * view,
+         glm::vec4(glm::normalize(glm::vec3(lightX, lightY, lightZ)), 0.0f),
+         glm::vec4(camera.Position, 1.0f)});
+
+    skyRenderer.renderSkybox();
+
+    if (renderWireframe)
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    else
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
     glBindVertexArray(VAO);
     glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
 
     auto frustum = camera.getFrustum();
 
-    int subChunksRendered = 0;
-
     int xMin = camera.Position.x / Chunk::WIDTH - camera.viewDistance;
     int xMax = camera.Position.x / Chunk::WIDTH + camera.viewDistance;
     int zMin = camera.Position.z / Chunk::DEPTH - camera.viewDistance;
     int zMax = camera.Position.z / Chunk::DEPTH + camera.viewDistance;
-    int yMin = 0;
-    int yMax = Chunk::HEIGHT / Chunk::WIDTH;
 
-    std::unordered_set<size_t> rendered_chunks{};
+    constexpr int margin = ChunkResidency::EVICT_MARGIN;
+    // chunks leaving the window are the only ones visited, nothing else is
+    // scanned. Window spans hysteresis band and 1 chunk for mesher neighbours
+    residency.update(world, {xMin - 1 - margin, zMin - 1 - margin},
+                     xMax - xMin + 3 + 2 * margin);
 
     bufferPool->bind();
 
     const int RADIUS =
         camera.viewDistance * camera.viewDistance * Chunk::WIDTH * Chunk::WIDTH;
+    const int KEEP_RADIUS = (camera.viewDistance + margin) *
+                            (camera.viewDistance + margin) * Chunk::WIDTH *
+                            Chunk::WIDTH;
 
-    for (int x = xMin; x < xMax; x++) {
-        for (int z = zMin; z < zMax; z++) {
+    int chunkUpdates = 0;
+    for (int x = xMin - margin; x < xMax + margin; x++) {
+        for (int z = zMin - margin; z < zMax + margin; z++) {
             float chunkCenterX = (x + 0.5f) * Chunk::WIDTH;
             float chunkCenterZ = (z + 0.5f) * Chunk::DEPTH;
 
@@ -180,59 +486,78 @@ int WorldRenderer::render(World& world, const Camera& camera) {
             float dz = chunkCenterZ - camera.Position.z;
             float distanceSquared = dx * dx + dz * dz;
 
+            if (distanceSquared > KEEP_RADIUS) {
+                residency.release(world, x, z);
+                continue;
+            }
+            // hysteresis band, chunk keeps whatever it has but is not drawn
             if (distanceSquared > RADIUS) continue;
 
-            // const int LODLevel = std::min(int(sqrtf(distanceSquared) /
-            // Chunk::WIDTH / LOD_DISTANCE), LOD_LEVELS);
+            const uint32_t slot = residency.acquire(world, x, z);
+            bufferPool->reserveSlots(world.chunks.slotCount());
+            auto& record = residency[slot];
 
-            int y0 = -1;
-            int y1 = -1;
-
-            const size_t id = Chunk::getId(x, z);
-            if (!bufferPool->containsAllocation(id)) {
-                // if (LODLevel == 0)
-                ChunkMesher::update(world, {x, z}, *bufferPool);
-                // else ChunkMesher::updateLOD(world, {x, z}, bufferPool,
-                // LODLevel);
+            const int LOD =
+                selectLOD(sqrtf(distanceSquared) / Chunk::WIDTH, record.LOD);
+            if (LOD != record.LOD) {
+                residency.releaseMesh(world, slot);
+                record.LOD = LOD;
             }
 
-            rendered_chunks.emplace(id);
-
-            for (int y = yMin; y < yMax; y++) {
-                AABB chunkBox = getSubChunkBoundingBox(glm::vec3(
-                    x * Chunk::WIDTH, y * Chunk::WIDTH, z * Chunk::DEPTH));
-                if (frustum.isAABBVisible(chunkBox)) {
-                    if (y0 == -1) y0 = y;
-                    y1 = y;
-                    subChunksRendered++;
+            Chunk& chunk = world.chunks[slot];
+            if (chunk.state != ChunkState::UPLOADED) {
+                if (chunkUpdates >= CHUNK_UPDATES_PER_FRAME) continue;
+                chunkUpdates++;
+                if (LOD == 0) {
+                    world.generate(slot);
+                    ChunkMesher::update(world, {x, z}, *bufferPool);
+                } else {
+                    // generates blocks itself if the pyramid is missing
+                    ChunkMesher::updateLOD(world, {x, z}, *bufferPool, LOD);
                 }
+            } else if (chunk.data.dirtySections &&
+                       chunkUpdates < CHUNK_UPDATES_PER_FRAME) {
+                // edited chunk keeps drawing its old mesh until remeshed
+                chunkUpdates++;
+                if (LOD == 0)
+                    ChunkMesher::updateDirty(world, {x, z}, *bufferPool);
+                else
+                    ChunkMesher::updateLOD(world, {x, z}, *bufferPool, LOD);
             }
-            // TODO allocation is wrong...
-            renderChunk(id, {x, z}, y0, y1, camera.Position,
-                        bufferPool->chunkViewData[id]);
         }
     }
 
-    for (const auto& chunk : world.chunks) {
-        if (!rendered_chunks.contains(chunk.first)) {
-            bufferPool->deallocate(chunk.first);
-        }
-    }
+    meshRevision += chunkUpdates;
 
-    std::erase_if(world.chunks, [xMin, xMax, zMin, zMax](const auto& iter) {
-        bool erase =
-            iter.second.xCoord < xMin - 1 || iter.second.xCoord > xMax + 1 ||
-            iter.second.zCoord < zMin - 1 || iter.second.zCoord > zMax + 1;
-        return erase;
-    });
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = drawListCache.lookup(
+        DrawListCache::makeKey(camera, world.getRevision() +
+                                           residency.getRevision() +
+                                           meshRevision),
+        view);
+    if (result == DrawListCache::Result::MISS)
+        collectDraws(world, camera, sqrtf(RADIUS));
+    if (result != DrawListCache::Result::HIT)
+        buildDrawList(world, camera, frustum, sqrtf(RADIUS));
+    drawListCache.finish(result, std::chrono::duration<double, std::micro>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count());
+
+    submitDrawList();
+
+    residency.enforceBudget(world);
 
     // glFlush();
 
-    return subChunksRendered;
+    size_t batchCount = 0;
+    for (const auto& layerBatches : batches) batchCount += layerBatches.size();
+    return static_cast<int>(batchCount);
 }
 
 WorldRenderer::~WorldRenderer() {
-    delete shader;
+    delete opaqueProgram.shader;
+    delete alphaProgram.shader;
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &indirectBuffer);
+    glDeleteQueries(OVERDRAW_QUERIES, overdrawQueries.data());
 }
@@ -1,18 +1,37 @@
 #pragma once
 
+#include <array>
 #include <vector>
 
+#include "ChunkResidency.hpp"
 #include "SkyRenderer.hpp"
 #include "game/world/EFacing.h"
 #include "game/world/World.h"
 #include "render/Camera.h"
+#include "render/CaveCuller.hpp"
+#include "render/DrawListCache.hpp"
+#include "render/FrustumCuller.hpp"
+#include "render/OcclusionCuller.hpp"
 #include "render/buffers/MappedBufferPool.h"
+#include "render/utils/FrameUniforms.h"
 #include "render/utils/Shader.h"
 
 class WorldRenderer {
     GPU::MappedChunkBuffer* bufferPool = nullptr;
 
-    Shader* shader = nullptr;
+    // program drawing faces, with its per draw uniforms
+    struct FaceProgram {
+        Shader* shader = nullptr;
+        Uniform<glm::ivec3> chunkCoords;
+        Uniform<float> lodScale;
+    };
+    // opaque faces, without alpha test early depth test always applies
+    FaceProgram opaqueProgram;
+    // cutout and translucent faces, fragments below alphaCutoff are dropped
+    FaceProgram alphaProgram;
+    Uniform<float> alphaCutoffUniform;
+    const FaceProgram* program = nullptr;
+    FrameUniforms frameUniforms;
     SkyRenderer skyRenderer;
 
     GLuint VAO = 0;
@@ -27,18 +46,114 @@ class WorldRenderer {
         GLuint baseInstance;
     } DrawArraysIndirectCommand;
 
-    std::vector<DrawArraysIndirectCommand> cmds;
-
-    void renderChunk(size_t id, const glm::ivec2& coords, size_t y0, size_t y1,
-                     const glm::vec3& cameraCoords,
-                     const GPU::MappedChunkBuffer::ChunkBufferView& buffer);
-    void renderSubChunk(const glm::ivec3& coords, const glm::vec3& cameraCoords,
-                        size_t offset,
-                        const GPU::MappedChunkBuffer::ChunkBufferView& buffer);
-    static void renderSubChunkFacing(
-        const GPU::MappedChunkBuffer::ChunkBufferView& buf, int y, Facing f,
-        size_t offset, std::vector<DrawArraysIndirectCommand>& cmds);
+    struct SubChunkBatch {
+        glm::ivec3 coords;
+        int LOD;
+        uint32_t firstCommand;
+        uint32_t commandCount;
+    };
+    // batches of every render layer, opaque and cutout ones front to back,
+    // translucent ones back to front. Commands are in the indirect buffer
+    std::array<std::vector<SubChunkBatch>, RENDER_LAYERS> batches;
+
+    // Commands and batches one worker recorded for a range of sorted
+    // sections, firstCommand counts from the start of its own commands
+    struct CommandList {
+        std::vector<DrawArraysIndirectCommand> cmds;
+        std::array<std::vector<SubChunkBatch>, RENDER_LAYERS> batches;
+        size_t base = 0; // of its commands in the indirect buffer
+    };
+    std::vector<CommandList> commandLists;
+
+    // Frame preparation is split into tiles handed to the job system,
+    // columns culled and sections recorded per job
+    static constexpr size_t COLUMNS_PER_TILE = 16;
+    static constexpr size_t SECTIONS_PER_LIST = 256;
+
+    // Chunks generated or meshed per frame at most, the rest stay queued
+    static constexpr int CHUNK_UPDATES_PER_FRAME = 16;
+
+    ChunkResidency residency;
+    int currentLOD = -1;
+
+    // Chunks this close (in chunks) occlude, farther ones hide little
+    static constexpr int OCCLUDER_DISTANCE = 6;
+
+    struct ChunkDraw {
+        uint32_t slot;
+        glm::ivec2 coords;
+        int LOD;
+        uint8_t sections; // sections left to draw
+    };
+
+    // chunks collected for the whole camera cell, see DrawListCache
+    std::vector<ChunkDraw> draws;
+    // columns of draws and their sections in the exact frustum, tested in one batch
+    std::vector<glm::ivec2> drawColumns;
+    std::vector<uint8_t> frustumSections;
+
+    // Steps per block of the distance sections are sorted by
+    static constexpr float DISTANCE_STEPS = 4.0f;
+
+    struct SectionDraw {
+        uint32_t distance; // quantized, from camera to section centre
+        uint32_t slot;
+        glm::ivec3 coords;
+        int LOD;
+    };
+    // sections passing exact culling, sorted near to far
+    std::vector<SectionDraw> sectionDraws;
+    // sections of each tile of draws before they are merged
+    std::vector<std::vector<SectionDraw>> tileSections;
+    std::vector<SectionDraw> sortScratch;
+    // opaque and cutout sections near to far, otherwise far to near to see
+    // how much the order saves
+    bool frontToBack = true;
+
+    // Fragments of opaque and cutout passes passing the depth test. Results
+    // are read OVERDRAW_QUERIES frames late, the GPU is never waited for
+    static constexpr int OVERDRAW_QUERIES = 3;
+    std::array<GLuint, OVERDRAW_QUERIES> overdrawQueries{};
+    uint64_t overdrawFrame = 0;
+
+   public:
+    struct OverdrawStats {
+        uint64_t fragments = 0;
+        uint64_t pixels = 0;
+
+        double fragmentsPerPixel() const {
+            return pixels ? static_cast<double>(fragments) / pixels : 0.0;
+        }
+    };
+
+   private:
+    OverdrawStats overdrawStats;
+    DrawListCache drawListCache;
+    // bumped by every mesh update, meshes may move in the buffer pool
+    uint64_t meshRevision = 0;
+    FrustumCuller frustumCuller;
+    std::vector<AABB> occluders;
+    OcclusionCuller occlusionCuller;
+    CaveCuller caveCuller;
+
+    void collectDraws(const World& world, const Camera& camera,
+                      float drawRadius);
+    void buildDrawList(const World& world, const Camera& camera,
+                       const Frustum& frustum, float drawRadius);
+    void submitDrawList();
+    void submitBatches(const std::vector<SubChunkBatch>& layerBatches);
+    void useProgram(const FaceProgram& faceProgram);
+    void readOverdrawQuery(GLuint query);
+    void cullTile(size_t tile, const glm::vec3& camera, float drawRadius);
+    void recordCommandList(size_t list, const glm::vec3& camera);
+    void recordSubChunk(const SectionDraw& section, RenderLayer layer,
+                        const glm::vec3& cameraCoords, CommandList& list);
+    static void recordSubChunkFacing(
+        const GPU::MappedChunkBuffer::ChunkBufferView& buf, int y, int group,
+        size_t offset, size_t firstCommand,
+        std::vector<DrawArraysIndirectCommand>& cmds);
     void renderChunkGrid(const Camera& camera);
+    void setLOD(int LOD);
 
    public:
     int render(World& w, const Camera& c);
@@ -46,8 +161,20 @@ class WorldRenderer {
     void init();
 
     GPU::MappedChunkBuffer& getBufferPool() { return *bufferPool; }
+    const ChunkResidency& getResidency() const { return residency; }
+    OcclusionCuller& getOcclusionCuller() { return occlusionCuller; }
+    DrawListCache& getDrawListCache() { return drawListCache; }
+    const Shader& getShader() const { return *opaqueProgram.shader; }
 
     void switchWireframeRendering() { renderWireframe = !renderWireframe; }
+    bool switchDrawOrder() {
+        frontToBack = !frontToBack;
+        drawListCache.invalidate();
+        return frontToBack;
+    }
+
+    const OverdrawStats& getOverdrawStats() const { return overdrawStats; }
+    void resetOverdrawStats() { overdrawStats = {}; }
 
     ~WorldRenderer();
     explicit WorldRenderer(const Camera& camera) {}
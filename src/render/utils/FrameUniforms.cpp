@@ -0,0 +1,17 @@
+#include "FrameUniforms.h"
+
+void FrameUniforms::init() {
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Data), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, buffer);
+}
+
+void FrameUniforms::update(const Data& data) const {
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Data), &data);
+}
+
+FrameUniforms::~FrameUniforms() {
+    glDeleteBuffers(1, &buffer);
+}
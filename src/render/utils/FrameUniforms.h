@@ -0,0 +1,29 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+// Uniforms shared by all draws of a frame, kept in one std140 uniform buffer written once per frame.
+// Shaders declare it as uniform block Frame and get it through binding point BINDING
+class FrameUniforms {
+public:
+    static constexpr GLuint BINDING = 0;
+    static constexpr const char* BLOCK_NAME = "Frame";
+
+    // layout of the block, std140 aligns vec3 like vec4
+    struct Data {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 viewProjection;
+        glm::vec4 lightDir;
+        glm::vec4 cameraPos;
+    };
+
+    void init();
+
+    void update(const Data& data) const;
+
+    ~FrameUniforms();
+
+private:
+    GLuint buffer = 0;
+};
@@ -1,5 +1,9 @@
 #include "Shader.h"
 
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -7,89 +11,190 @@
 #include <vector>
 #include <glad/glad.h>
 
-Shader::Shader(const char* vertPath, const char* fragPath, const char* geomPath) {
-    const auto vertex = LoadFile(vertPath);
-    const auto fragment = LoadFile(fragPath);
+namespace {
+    // linked programs are cached here, by hash of sources and driver
+    const std::filesystem::path CACHE_DIR = "shader_cache";
 
-    const auto vertex_c = vertex.c_str();
-    const auto fragment_c = fragment.c_str();
+    constexpr std::array<GLenum, 3> STAGES = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER};
 
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertex_c, nullptr);
-    glCompileShader(vertexShader);
+    // program whose compilation was started but whose result was not asked for yet
+    struct Pending {
+        GLuint program = 0;
+        std::array<GLuint, 3> shaders{}; // 0 for stages not used or when loaded from cache
+        uint64_t hash = 0;
+        bool cached = false;
+    };
 
-    GLint status;
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &status);
+    std::unordered_map<std::string, Pending> pending;
+    Shader::StartupStats startupStats;
 
-    if (status == GL_FALSE) {
-        GLint logSize = 0;
+    std::string programKey(const char* vertPath, const char* fragPath, const char* geomPath) {
+        return std::string(vertPath) + '|' + fragPath + '|' + (geomPath ? geomPath : "");
+    }
 
-        glGetShaderiv(vertexShader, GL_INFO_LOG_LENGTH, &logSize);
+    uint64_t fnv1a(const std::string_view data, uint64_t hash = 14695981039346656037ull) {
+        for (const char c : data) hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+        return hash;
+    }
 
-        std::vector<GLchar> message = std::vector<GLchar>(logSize);
+    // binary of one driver does not load into another, or into another version of the same one
+    std::string driverString() {
+        std::string result;
+        for (const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+            if (const auto* value = glGetString(name)) result += reinterpret_cast<const char*>(value);
+            result += '|';
+        }
+        return result;
+    }
 
-        glGetShaderInfoLog(vertexShader, logSize, nullptr, &message[0]);
-        glDeleteShader(vertexShader);
+    std::filesystem::path cachePath(const uint64_t hash) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(hash));
+        return CACHE_DIR / name;
+    }
 
-        std::cout << std::string(message.begin(), message.end());
+    bool binaryCacheSupported() {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
     }
 
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragment_c, nullptr);
-    glCompileShader(fragmentShader);
+    // Program from binary cache, 0 if there is none or the driver rejects it
+    GLuint loadBinary(const uint64_t hash) {
+        std::ifstream file(cachePath(hash), std::ios::binary);
+        if (!file) return 0;
+        GLenum format = 0;
+        file.read(reinterpret_cast<char*>(&format), sizeof(format));
+        if (!file.good()) return 0;
+        // istreambuf_iterator does not set eofbit, reading stops at the end on its own
+        const std::vector<char> binary((std::istreambuf_iterator(file)), std::istreambuf_iterator<char>());
+        if (binary.empty()) return 0;
+
+        const GLuint program = glCreateProgram();
+        glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+        GLint status = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (status == GL_FALSE) {
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
 
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &status);
+    void saveBinary(const GLuint program, const uint64_t hash) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+        std::error_code error;
+        std::filesystem::create_directories(CACHE_DIR, error);
+        std::ofstream file(cachePath(hash), std::ios::binary);
+        if (!file) return;
+        file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+        file.write(binary.data(), length);
+    }
 
-    if (status == GL_FALSE) {
+    std::string infoLog(const GLuint object, const bool program) {
         GLint logSize = 0;
-
-        glGetShaderiv(fragmentShader, GL_INFO_LOG_LENGTH, &logSize);
-
-        std::vector<GLchar> message = std::vector<GLchar>(logSize);
-
-        glGetShaderInfoLog(fragmentShader, logSize, nullptr, &message[0]);
-        glDeleteShader(fragmentShader);
-
-        std::cout << std::string(message.begin(), message.end());
+        if (program) glGetProgramiv(object, GL_INFO_LOG_LENGTH, &logSize);
+        else glGetShaderiv(object, GL_INFO_LOG_LENGTH, &logSize);
+        std::vector<GLchar> message(logSize + 1);
+        if (program) glGetProgramInfoLog(object, logSize, nullptr, message.data());
+        else glGetShaderInfoLog(object, logSize, nullptr, message.data());
+        return message.data();
     }
 
-    GLuint geomShader=0;
-
-    // Link shader program
-    ID = glCreateProgram();
-    glAttachShader(ID, vertexShader);
-    glAttachShader(ID, fragmentShader);
-
-    if (geomPath) {
-        const auto geom = LoadFile(geomPath);
-        const auto geom_c = geom.c_str();
-        geomShader = glCreateShader(GL_GEOMETRY_SHADER);
-        glShaderSource(geomShader, 1, &geom_c, nullptr);
-        glCompileShader(geomShader);
-
-        glGetShaderiv(geomShader, GL_COMPILE_STATUS, &status);
+    // Starts compiling and linking, nothing here waits for the driver
+    Pending start(const char* vertPath, const char* fragPath, const char* geomPath,
+                  std::string (*load)(const char*)) {
+        const std::array<const char*, 3> paths = {vertPath, fragPath, geomPath};
+        std::array<std::string, 3> sources;
+        uint64_t hash = fnv1a(driverString());
+        for (int i = 0; i < 3; i++) {
+            if (!paths[i]) continue;
+            sources[i] = load(paths[i]);
+            hash = fnv1a(sources[i], fnv1a(std::to_string(i), hash));
+        }
 
-        if (status == GL_FALSE) {
-            GLint logSize = 0;
+        const bool cacheable = binaryCacheSupported();
+        if (cacheable) {
+            if (const GLuint program = loadBinary(hash)) return {program, {}, hash, true};
+        }
 
-            glGetShaderiv(geomShader, GL_INFO_LOG_LENGTH, &logSize);
+        Pending result{glCreateProgram(), {}, hash, false};
+        for (int i = 0; i < 3; i++) {
+            if (!paths[i]) continue;
+            const char* source = sources[i].c_str();
+            result.shaders[i] = glCreateShader(STAGES[i]);
+            glShaderSource(result.shaders[i], 1, &source, nullptr);
+            glCompileShader(result.shaders[i]);
+            glAttachShader(result.program, result.shaders[i]);
+        }
+        if (cacheable) glProgramParameteri(result.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(result.program);
+        return result;
+    }
+}
 
-            std::vector<GLchar> message = std::vector<GLchar>(logSize);
+void Shader::preload(const std::initializer_list<Sources> programs) {
+    const auto begin = std::chrono::steady_clock::now();
+    for (const auto& [vert, frag, geom] : programs) {
+        const std::string key = programKey(vert, frag, geom);
+        if (!pending.contains(key)) pending.emplace(key, start(vert, frag, geom, LoadFile));
+    }
+    startupStats.microseconds += std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - begin).count();
+}
 
-            glGetShaderInfoLog(geomShader, logSize, nullptr, &message[0]);
-            glDeleteShader(geomShader);
+const Shader::StartupStats& Shader::getStartupStats() {
+    return startupStats;
+}
 
-            std::cout << std::string(message.begin(), message.end());
-        }
-        glAttachShader(ID, geomShader);
+Shader::Shader(const char* vertPath, const char* fragPath, const char* geomPath) {
+    const auto begin = std::chrono::steady_clock::now();
+
+    // program preloaded with the same sources is compiled already, or at least compiling
+    Pending program;
+    if (const auto it = pending.find(programKey(vertPath, fragPath, geomPath)); it != pending.end()) {
+        program = it->second;
+        pending.erase(it);
+    } else {
+        program = start(vertPath, fragPath, geomPath, LoadFile);
+    }
+    ID = program.program;
+
+    // waits for the driver
+    std::string errors;
+    GLint status = GL_FALSE;
+    const std::array<const char*, 3> paths = {vertPath, fragPath, geomPath};
+    for (int i = 0; i < 3; i++) {
+        if (!program.shaders[i]) continue;
+        glGetShaderiv(program.shaders[i], GL_COMPILE_STATUS, &status);
+        if (status == GL_FALSE) errors += std::string(paths[i]) + ": " + infoLog(program.shaders[i], false);
+        glDetachShader(ID, program.shaders[i]);
+        glDeleteShader(program.shaders[i]);
+    }
+    glGetProgramiv(ID, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) errors += "link: " + infoLog(ID, true);
+    if (!errors.empty()) {
+        glDeleteProgram(ID);
+        throw std::runtime_error("Could not build shader program " + programKey(vertPath, fragPath, geomPath) +
+                                 "\n" + errors);
     }
 
-    glLinkProgram(ID);
+    if (program.cached) {
+        startupStats.cached++;
+    } else {
+        startupStats.compiled++;
+        if (binaryCacheSupported()) saveBinary(ID, program.hash);
+    }
 
-    // Cleanup shaders
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-    if (geomShader) glDeleteShader(geomShader);
+    readLocations();
+    startupStats.microseconds += std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - begin).count();
 }
 
 Shader::~Shader() {
@@ -100,6 +205,32 @@ void Shader::use() const {
     glUseProgram(ID);
 }
 
+void Shader::readLocations() {
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<GLchar> name(maxLength + 1);
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, i, static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+        std::string uniform(name.data(), length);
+        const GLint location = glGetUniformLocation(ID, uniform.c_str());
+        // members of uniform blocks have no location
+        if (location == -1) continue;
+        // arrays are reported as name[0], set by their plain name
+        if (uniform.ends_with("[0]")) uniform.resize(uniform.size() - 3);
+        locations.emplace(std::move(uniform), location);
+    }
+}
+
+void Shader::bindUniformBlock(const char* name, const GLuint binding) const {
+    const GLuint index = glGetUniformBlockIndex(ID, name);
+    if (index != GL_INVALID_INDEX) glUniformBlockBinding(ID, index, binding);
+}
+
 std::string Shader::LoadFile(const char* path) {
     std::ifstream file(path);
     if (!file) throw std::runtime_error("Could not open file " + std::string(path));
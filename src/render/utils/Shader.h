@@ -1,53 +1,128 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <initializer_list>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <glad/glad.h>
 
+class Shader;
+
+// Location of a uniform resolved when the program was linked, set without any lookup.
+// Applies to the program in use, like glUniform* does
+template <typename T>
+class Uniform {
+public:
+    Uniform() = default;
+    explicit Uniform(const GLint location) : location(location) {}
+
+    void set(const T& value) const;
+
+    // false if the program has no such active uniform, setting it does nothing then
+    bool isValid() const { return location != -1; }
+
+private:
+    GLint location = -1;
+};
+
 class Shader {
 public:
+    struct Sources {
+        const char* vert;
+        const char* frag;
+        const char* geom = nullptr;
+    };
+
+    struct StartupStats {
+        int cached = 0; // programs loaded from binary cache
+        int compiled = 0;
+        double microseconds = 0; // spent building programs, waits for the driver included
+    };
+
+    // Starts building all programs at once, so the driver may compile them in parallel. Shaders
+    // constructed later with the same sources take them over. Programs are loaded from binary cache
+    // when they were built before with the same sources and driver
+    static void preload(std::initializer_list<Sources> programs);
+    static const StartupStats& getStartupStats();
+
+    // Throws if the program does not compile or link
     Shader(const char* vertPath, const char* fragPath, const char* geomPath = nullptr);
 
     void use() const;
 
-    void setMat4(const std::string& name, const glm::mat4& mat) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    template <typename T>
+    Uniform<T> getUniform(const std::string_view name) const { return Uniform<T>(getLocation(name)); }
+
+    // Connects uniform block of the program to buffer binding point, nothing if there is no such block
+    void bindUniformBlock(const char* name, GLuint binding) const;
+
+    void setMat4(const std::string_view name, const glm::mat4& mat) const {
+        upload(getLocation(name), mat);
     }
 
-    void setMat3(const std::string& name, const glm::mat3& mat) const {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    void setMat3(const std::string_view name, const glm::mat3& mat) const {
+        upload(getLocation(name), mat);
     }
 
-    void setFloat(const std::string& name, float val) const {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), val);
+    void setFloat(const std::string_view name, float val) const {
+        upload(getLocation(name), val);
     }
 
-    void setSampler(const std::string& name, GLuint sampler) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), sampler);
+    void setSampler(const std::string_view name, GLuint sampler) const {
+        upload(getLocation(name), static_cast<int32_t>(sampler));
     }
 
-    void setVec3(const std::string& name, const glm::vec3& value) const {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    void setVec3(const std::string_view name, const glm::vec3& value) const {
+        upload(getLocation(name), value);
     }
 
-    void setIVec3(const std::string& name, const glm::ivec3 value) const {
-        glUniform3i(glGetUniformLocation(ID, name.c_str()), value.x, value.y, value.z);
+    void setIVec3(const std::string_view name, const glm::ivec3 value) const {
+        upload(getLocation(name), value);
     }
 
-    void setInt32(const std::string& name, const int32_t value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    void setInt32(const std::string_view name, const int32_t value) const {
+        upload(getLocation(name), value);
     }
 
-    void setInt32s(const std::string& name, const std::vector<int32_t>& values) const {
-        glUniform1iv(glGetUniformLocation(ID, name.c_str()), values.size(), values.data());
+    void setInt32s(const std::string_view name, const std::vector<int32_t>& values) const {
+        glUniform1iv(getLocation(name), values.size(), values.data());
     }
 
     GLuint getID() const { return ID; }
 
+    static void upload(GLint location, const glm::mat4& mat) { glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]); }
+    static void upload(GLint location, const glm::mat3& mat) { glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]); }
+    static void upload(GLint location, const float val) { glUniform1f(location, val); }
+    static void upload(GLint location, const int32_t val) { glUniform1i(location, val); }
+    static void upload(GLint location, const glm::vec3& value) { glUniform3fv(location, 1, &value[0]); }
+    static void upload(GLint location, const glm::ivec3& value) { glUniform3i(location, value.x, value.y, value.z); }
+
     ~Shader();
 
 private:
     GLuint ID;
 
+    // names hash as string views, so lookups by literal allocate nothing
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(const std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+    // locations of active uniforms, read once after linking
+    std::unordered_map<std::string, GLint, NameHash, std::equal_to<>> locations;
+
+    // -1 (ignored by glUniform*) for names the program does not use
+    GLint getLocation(const std::string_view name) const {
+        const auto it = locations.find(name);
+        return it == locations.end() ? -1 : it->second;
+    }
+
+    void readLocations();
+
     static std::string LoadFile(const char* path);
 };
+
+template <typename T>
+void Uniform<T>::set(const T& value) const {
+    Shader::upload(location, value);
+}
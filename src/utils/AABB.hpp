@@ -1,6 +1,10 @@
 #pragma once
+#include <cstdint>
 #include <glm/vec3.hpp>
 
+// How much of a box passes a test, ordered so the weaker of two results is the smaller
+enum class Containment : uint8_t { OUTSIDE, PARTIAL, INSIDE };
+
 struct AABB {
     glm::vec3 min;
     glm::vec3 max;
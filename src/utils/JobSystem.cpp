@@ -0,0 +1,188 @@
+#include "JobSystem.hpp"
+
+#include <iostream>
+
+namespace {
+    // queue index of the current thread, -1 outside the system
+    thread_local int threadIndex = -1;
+
+    // xorshift, picks where stealing starts so thieves spread over victims
+    uint32_t nextVictim() {
+        thread_local uint32_t state = 0x9E3779B9u ^ static_cast<uint32_t>(threadIndex + 1);
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    void report(const std::exception_ptr& error) {
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& e) {
+            std::cerr << "Job failed: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Job failed" << std::endl;
+        }
+    }
+}
+
+void JobSystem::start(const unsigned workerCount) {
+    stop();
+    queues = std::make_unique<Queues[]>(workerCount + 1);
+    threads = workerCount + 1;
+    threadIndex = 0;
+    running = true;
+    workers.reserve(workerCount);
+    for (unsigned i = 1; i <= workerCount; i++) workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+void JobSystem::stop() {
+    if (!running.exchange(false)) return;
+    epoch.fetch_add(1);
+    epoch.notify_all();
+    for (auto& worker : workers) worker.join();
+    dropQueued();
+    workers.clear();
+    threads = 1;
+}
+
+// Only the calling thread is left, so it may pop deques of others too
+void JobSystem::dropQueued() {
+    for (unsigned i = 0; i < threadCount(); i++)
+        for (auto& deque : queues[i])
+            while (const auto job = deque.pop()) finish(*job);
+    for (auto& queue : injected)
+        for (Job* job : queue) finish(job);
+    for (Job* job : mainJobs) finish(job);
+    for (auto& queue : injected) queue.clear();
+    injectedCount = 0;
+    mainJobs.clear();
+}
+
+void JobSystem::submit(std::function<void()> task, Counter* counter, const Priority priority) {
+    // nothing would run it before start
+    if (!running) {
+        task();
+        return;
+    }
+    if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+    Job* job = new Job{std::move(task), counter};
+    const int p = static_cast<int>(priority);
+    if (threadIndex >= 0) {
+        queues[threadIndex][p].push(job);
+    } else {
+        std::lock_guard lock(injectedMutex);
+        injected[p].push_back(job);
+        injectedCount++;
+    }
+    wake();
+}
+
+void JobSystem::submitMain(std::function<void()> task, Counter* counter) {
+    if (!running) {
+        task();
+        return;
+    }
+    if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard lock(mainMutex);
+    mainJobs.push_back(new Job{std::move(task), counter});
+}
+
+void JobSystem::wait(const Counter& counter) {
+    while (!counter.done()) {
+        if (threadIndex == 0 && runMainJob()) continue;
+        if (Job* job = findJob(threadIndex))
+            run(job);
+        else
+            std::this_thread::yield();
+    }
+    if (counter.failed.load(std::memory_order_acquire)) std::rethrow_exception(counter.error);
+}
+
+void JobSystem::runMainThreadJobs() {
+    while (runMainJob()) {}
+    // nobody else would run them
+    if (isSingleThreaded())
+        while (Job* job = findJob(0)) run(job);
+}
+
+void JobSystem::workerLoop(const unsigned index) {
+    threadIndex = static_cast<int>(index);
+    while (running.load(std::memory_order_relaxed)) {
+        if (Job* job = findJob(threadIndex)) {
+            run(job);
+            continue;
+        }
+        // a submit after reading epoch changes it, so wait returns at once and nothing is missed
+        const uint32_t seen = epoch.load();
+        if (Job* job = findJob(threadIndex)) {
+            run(job);
+            continue;
+        }
+        sleeping++;
+        epoch.wait(seen);
+        sleeping--;
+    }
+}
+
+JobSystem::Job* JobSystem::findJob(const int index) {
+    if (!queues) return nullptr;
+    const int count = static_cast<int>(threadCount());
+    for (int p = 0; p < PRIORITIES; p++) {
+        if (index >= 0)
+            if (const auto job = queues[index][p].pop()) return *job;
+        if (Job* job = takeInjected(p)) return job;
+        const int first = static_cast<int>(nextVictim() % count);
+        for (int i = 0; i < count; i++) {
+            const int victim = (first + i) % count;
+            if (victim == index) continue;
+            if (const auto job = queues[victim][p].steal()) return *job;
+        }
+    }
+    return nullptr;
+}
+
+JobSystem::Job* JobSystem::takeInjected(const int priority) {
+    if (!injectedCount.load(std::memory_order_relaxed)) return nullptr;
+    std::lock_guard lock(injectedMutex);
+    if (injected[priority].empty()) return nullptr;
+    Job* job = injected[priority].front();
+    injected[priority].pop_front();
+    injectedCount--;
+    return job;
+}
+
+bool JobSystem::runMainJob() {
+    Job* job;
+    {
+        std::lock_guard lock(mainMutex);
+        if (mainJobs.empty()) return false;
+        job = mainJobs.front();
+        mainJobs.pop_front();
+    }
+    run(job);
+    return true;
+}
+
+void JobSystem::run(Job* job) {
+    try {
+        job->task();
+    } catch (...) {
+        Counter* counter = job->counter;
+        if (!counter)
+            report(std::current_exception());
+        else if (!counter->failed.exchange(true, std::memory_order_relaxed))
+            counter->error = std::current_exception();
+    }
+    finish(job);
+}
+
+void JobSystem::finish(Job* job) {
+    if (job->counter) job->counter->pending.fetch_sub(1, std::memory_order_release);
+    delete job;
+}
+
+void JobSystem::wake() {
+    epoch.fetch_add(1);
+    if (sleeping.load()) epoch.notify_one();
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "WorkStealingDeque.hpp"
+
+// Work-stealing scheduler shared by the whole engine.
+// Every worker and the main thread own a deque per priority, pushing and popping their own jobs
+// at the bottom while idle threads steal from the top of others. Jobs needing the GL context go
+// to a main thread queue instead. Waiting on a counter runs other jobs instead of blocking, so
+// jobs may fork and join freely.
+// A throwing job does not take its thread down. The first exception of a counter's jobs is rethrown
+// by wait, exceptions of jobs without counter are reported on std::cerr
+class JobSystem {
+public:
+    enum class Priority { HIGH, NORMAL, LOW };
+    static constexpr int PRIORITIES = 3;
+
+    // Jobs submitted with a counter are pending on it until they finish
+    class Counter {
+        friend class JobSystem;
+        std::atomic<uint32_t> pending = 0;
+        // set by the first job to throw, read once pending is 0
+        std::atomic<bool> failed = false;
+        std::exception_ptr error;
+
+    public:
+        bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+    };
+
+    // Starts workers besides the calling thread, which becomes the main thread. With no workers
+    // every job runs on the main thread in a fixed order, inside wait or runMainThreadJobs
+    void start(unsigned workers);
+    // Joins workers, jobs which did not run yet are dropped and their counters released
+    void stop();
+
+    void submit(std::function<void()> task, Counter* counter = nullptr, Priority priority = Priority::NORMAL);
+    // Runs task on the main thread, for GL calls
+    void submitMain(std::function<void()> task, Counter* counter = nullptr);
+
+    // Runs jobs until all of the counter's are done, main thread jobs too when called on it.
+    // Rethrows the first exception one of them threw
+    void wait(const Counter& counter);
+    // Main thread only, once per frame
+    void runMainThreadJobs();
+
+    // workers and main thread
+    unsigned threadCount() const { return threads; }
+    bool isSingleThreaded() const { return threads == 1; }
+
+    ~JobSystem() { stop(); }
+
+private:
+    struct Job {
+        std::function<void()> task;
+        Counter* counter;
+    };
+
+    using Queues = std::array<WorkStealingDeque<Job*>, PRIORITIES>;
+
+    // index 0 is the main thread, workers follow
+    std::unique_ptr<Queues[]> queues;
+    std::vector<std::thread> workers;
+    // set before workers start, they read it while workers is still growing
+    unsigned threads = 1;
+
+    // jobs of threads outside the system
+    std::mutex injectedMutex;
+    std::array<std::deque<Job*>, PRIORITIES> injected;
+    std::atomic<int> injectedCount = 0;
+
+    std::mutex mainMutex;
+    std::deque<Job*> mainJobs;
+
+    // bumped on every submit, sleeping workers wait for it to change
+    std::atomic<uint32_t> epoch = 0;
+    std::atomic<int> sleeping = 0;
+    std::atomic<bool> running = false;
+
+    void workerLoop(unsigned index);
+    Job* findJob(int index);
+    Job* takeInjected(int priority);
+    bool runMainJob();
+    static void run(Job* job);
+    static void finish(Job* job);
+    void dropQueued();
+    void wake();
+};
+
+inline JobSystem jobSystem;
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+// 2D Morton (Z-order) codes for 21 bit coordinates
+namespace morton {
+    constexpr uint64_t COORD_MASK = (1ull << 21) - 1;
+    constexpr uint64_t X_MASK = 0x5555555555555555ull;
+    constexpr uint64_t Z_MASK = 0xAAAAAAAAAAAAAAAAull;
+
+    // Inserts a zero bit in front of every bit of v
+    constexpr uint64_t spreadBits(uint64_t v) {
+        v &= COORD_MASK;
+        v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+        v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+        v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+        v = (v | (v << 2)) & 0x3333333333333333ull;
+        v = (v | (v << 1)) & 0x5555555555555555ull;
+        return v;
+    }
+
+    // Inverse of spreadBits, drops every odd bit
+    constexpr uint32_t compactBits(uint64_t v) {
+        v &= 0x5555555555555555ull;
+        v = (v | (v >> 1)) & 0x3333333333333333ull;
+        v = (v | (v >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+        v = (v | (v >> 4)) & 0x00FF00FF00FF00FFull;
+        v = (v | (v >> 8)) & 0x0000FFFF0000FFFFull;
+        v = (v | (v >> 16)) & 0x00000000FFFFFFFFull;
+        return static_cast<uint32_t>(v & COORD_MASK);
+    }
+
+    inline uint64_t encode(uint32_t x, uint32_t z) {
+#ifdef __BMI2__
+        return _pdep_u64(x & COORD_MASK, X_MASK) | _pdep_u64(z & COORD_MASK, Z_MASK);
+#else
+        return spreadBits(x) | (spreadBits(z) << 1);
+#endif
+    }
+
+    inline void decode(uint64_t code, uint32_t& x, uint32_t& z) {
+#ifdef __BMI2__
+        x = static_cast<uint32_t>(_pext_u64(code, X_MASK) & COORD_MASK);
+        z = static_cast<uint32_t>(_pext_u64(code, Z_MASK) & COORD_MASK);
+#else
+        x = compactBits(code);
+        z = compactBits(code >> 1);
+#endif
+    }
+}
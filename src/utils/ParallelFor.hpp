@@ -0,0 +1,38 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+
+#include "JobSystem.hpp"
+
+// Runs task(i) for every i in [0, count), spread over the threads of the job system.
+// Tasks are handed out one by one, so uneven tasks balance themselves. The calling thread takes
+// part and runs other jobs while waiting, so calls may nest inside jobs.
+// Runs inline when threads are not worth it (count below minParallel)
+template <typename Task>
+void parallelFor(const size_t count, Task&& task, const size_t minParallel = 2,
+                 const JobSystem::Priority priority = JobSystem::Priority::NORMAL) {
+    const size_t threads = std::min<size_t>(jobSystem.threadCount(), count);
+    if (count < minParallel || threads < 2) {
+        for (size_t i = 0; i < count; i++) task(i);
+        return;
+    }
+
+    std::atomic<size_t> next = 0;
+    const auto drain = [&] {
+        for (size_t i = next++; i < count; i = next++) task(i);
+    };
+    JobSystem::Counter counter;
+    for (size_t t = 1; t < threads; t++) jobSystem.submit(drain, &counter, priority);
+    // jobs still reference next and task, so they must finish before an exception leaves
+    try {
+        drain();
+    } catch (...) {
+        next = count;
+        try {
+            jobSystem.wait(counter);
+        } catch (...) {}
+        throw;
+    }
+    jobSystem.wait(counter);
+}
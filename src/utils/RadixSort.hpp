@@ -0,0 +1,33 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Stable sort of items by a 32 bit key, 8 bits per pass through scratch.
+// Passes stop at the highest digit any key uses and skip digits all keys
+// share, so keys of a few thousand values sort in one or two passes
+template <typename T, typename Key>
+void radixSort(std::vector<T>& items, std::vector<T>& scratch, Key&& key) {
+    if (items.size() < 2) return;
+
+    uint32_t maxKey = 0;
+    for (const T& item : items) maxKey = std::max<uint32_t>(maxKey, key(item));
+
+    scratch.resize(items.size());
+    for (int shift = 0; shift < 32 && maxKey >> shift; shift += 8) {
+        std::array<size_t, 256> starts{};
+        for (const T& item : items) starts[key(item) >> shift & 0xFF]++;
+        if (starts[key(items.front()) >> shift & 0xFF] == items.size()) continue;
+
+        size_t sum = 0;
+        for (size_t& start : starts) {
+            const size_t count = start;
+            start = sum;
+            sum += count;
+        }
+        for (T& item : items) scratch[starts[key(item) >> shift & 0xFF]++] = std::move(item);
+        items.swap(scratch);
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// Chase-Lev deque (with the memory orders of Le et al. 2013). The owning thread pushes and pops
+// at the bottom, any other thread steals from the top. Grows when full, replaced rings are kept
+// until the deque dies since a thief may still be reading one
+template <typename T>
+class WorkStealingDeque {
+    struct Ring {
+        explicit Ring(const int64_t capacity)
+            : mask(capacity - 1), items(std::make_unique<std::atomic<T>[]>(capacity)) {}
+
+        T load(const int64_t i) const { return items[i & mask].load(std::memory_order_relaxed); }
+        void store(const int64_t i, const T item) { items[i & mask].store(item, std::memory_order_relaxed); }
+        int64_t capacity() const { return mask + 1; }
+
+        int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> items;
+    };
+
+    alignas(64) std::atomic<int64_t> top = 0;
+    alignas(64) std::atomic<int64_t> bottom = 0;
+    std::atomic<Ring*> ring;
+    std::vector<std::unique_ptr<Ring>> rings;
+
+    Ring* grow(Ring* old, const int64_t t, const int64_t b) {
+        rings.push_back(std::make_unique<Ring>(old->capacity() * 2));
+        Ring* bigger = rings.back().get();
+        for (int64_t i = t; i < b; i++) bigger->store(i, old->load(i));
+        ring.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+public:
+    explicit WorkStealingDeque(const int64_t capacity = 256) {
+        rings.push_back(std::make_unique<Ring>(capacity));
+        ring.store(rings.back().get(), std::memory_order_relaxed);
+    }
+
+    // owner only
+    void push(const T item) {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        Ring* r = ring.load(std::memory_order_relaxed);
+        if (b - t >= r->capacity()) r = grow(r, t, b);
+        r->store(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // owner only, newest item first
+    std::optional<T> pop() {
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Ring* r = ring.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+        const T item = r->load(b);
+        if (t == b) {
+            // last item, thieves race for it too
+            const bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                         std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            if (!won) return std::nullopt;
+        }
+        return item;
+    }
+
+    // any thread, oldest item first. Empty also when another thief won the race
+    std::optional<T> steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return std::nullopt;
+
+        const T item = ring.load(std::memory_order_acquire)->load(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return std::nullopt;
+        return item;
+    }
+
+    // may be stale by the time it returns
+    bool empty() const {
+        return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+    }
+};
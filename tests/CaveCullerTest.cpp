@@ -0,0 +1,175 @@
+#include "Check.hpp"
+#include "game/world/World.h"
+#include "render/CaveCuller.hpp"
+
+// Section connectivity and the cave walk over hand built chunks of solid rock with holes
+namespace {
+    using Hole = bool (*)(int x, int y, int z);
+
+    // fills section with stone except where hole is true, coordinates local to the section
+    void carve(BlockType* section, const Hole hole) {
+        for (int y = 0; y < SectionVisibility::SIZE; y++)
+            for (int z = 0; z < SectionVisibility::SIZE; z++)
+                for (int x = 0; x < SectionVisibility::SIZE; x++)
+                    section[ChunkData::getIndex({x, y, z})] = hole(x, y, z) ? BlockType::AIR : BlockType::STONE;
+    }
+
+    SectionVisibility compute(const Hole hole) {
+        std::vector<BlockType> blocks(SectionVisibility::VOLUME);
+        carve(blocks.data(), hole);
+        return SectionVisibility::compute(blocks.data());
+    }
+
+    bool rock(int, int, int) { return false; }
+    bool air(int, int, int) { return true; }
+    bool room(const int x, const int y, const int z) {
+        return x > 8 && x < 24 && y > 8 && y < 24 && z > 8 && z < 24;
+    }
+    // through the middle of the section from west to east
+    bool tunnel(const int, const int y, const int z) { return y == 16 && z == 16; }
+    // from west face to the middle, then up
+    bool tunnelUp(const int x, const int y, const int z) {
+        return z == 16 && ((y == 16 && x <= 16) || (x == 16 && y >= 16));
+    }
+    // from bottom face to the middle, then east
+    bool tunnelEast(const int x, const int y, const int z) {
+        return z == 16 && ((x == 16 && y <= 16) || (y == 16 && x >= 16));
+    }
+
+    // faces connected in v, as pairs
+    int countPairs(const SectionVisibility& v) {
+        int pairs = 0;
+        for (int a = 0; a < 6; a++)
+            for (int b = a + 1; b < 6; b++)
+                pairs += v.connected(static_cast<Facing>(a), static_cast<Facing>(b));
+        return pairs;
+    }
+
+    void testPairs() {
+        uint16_t all = SectionVisibility::NONE;
+        for (int a = 0; a < 6; a++) {
+            SectionVisibility self{SectionVisibility::NONE};
+            self.connect(static_cast<Facing>(a), static_cast<Facing>(a));
+            CHECK(self.bits == SectionVisibility::NONE);
+            CHECK(self.connected(static_cast<Facing>(a), static_cast<Facing>(a)));
+
+            for (int b = a + 1; b < 6; b++) {
+                SectionVisibility v{SectionVisibility::NONE};
+                v.connect(static_cast<Facing>(a), static_cast<Facing>(b));
+                CHECK(v.connected(static_cast<Facing>(a), static_cast<Facing>(b)));
+                CHECK(v.connected(static_cast<Facing>(b), static_cast<Facing>(a)));
+                // every pair has a bit of its own
+                CHECK(countPairs(v) == 1);
+                CHECK(!(all & v.bits));
+                all |= v.bits;
+            }
+        }
+        CHECK(all == SectionVisibility::ALL);
+        CHECK(countPairs(SectionVisibility{}) == 15);
+    }
+
+    void testCompute() {
+        CHECK(compute(air).bits == SectionVisibility::ALL);
+        CHECK(compute(rock).bits == SectionVisibility::NONE);
+        // air which touches no face sees nothing
+        CHECK(compute(room).bits == SectionVisibility::NONE);
+
+        const SectionVisibility straight = compute(tunnel);
+        CHECK(countPairs(straight) == 1 && straight.connected(WEST, EAST));
+        const SectionVisibility bend = compute(tunnelUp);
+        CHECK(countPairs(bend) == 1 && bend.connected(WEST, UP));
+    }
+
+    void carve(World& world, const int x, const int z, const int section, const Hole hole) {
+        ChunkData& data = world.chunks[world.reserveSlot(x, z)].data;
+        carve(data.blocks.data() + section * SectionVisibility::VOLUME, hole);
+        data.updateVisibility(1 << section);
+    }
+
+    // solid rock from chunk -2 to 3 on x and -2 to 2 on z
+    void fillRock(World& world) {
+        for (int x = -2; x <= 3; x++)
+            for (int z = -2; z <= 2; z++)
+                for (int section = 0; section < Chunk::SUB_COUNT; section++)
+                    carve(world, x, z, section, rock);
+    }
+
+    uint8_t sections(const CaveCuller& culler, const World& world, const int x, const int z) {
+        return culler.getSections(world.chunks.findSlot(x, z));
+    }
+
+    // frustum which sees everything, so only connectivity decides
+    const Frustum EVERYWHERE{std::array<Plane, 6>{
+        Plane(glm::vec4(0, 0, 0, 1)), Plane(glm::vec4(0, 0, 0, 1)), Plane(glm::vec4(0, 0, 0, 1)),
+        Plane(glm::vec4(0, 0, 0, 1)), Plane(glm::vec4(0, 0, 0, 1)), Plane(glm::vec4(0, 0, 0, 1))
+    }};
+
+    // camera in the middle of section 2 of chunk 0, 0
+    constexpr glm::vec3 CAMERA{16.5f, 2 * Chunk::SUB_HEIGHT + 16.5f, 16.5f};
+    constexpr float RADIUS = 1000.0f;
+
+    void testSealedRoom() {
+        World world;
+        fillRock(world);
+        carve(world, 0, 0, 2, room);
+
+        CaveCuller culler;
+        culler.update(world, CAMERA, EVERYWHERE, RADIUS);
+        // faces of the camera section are not known to be closed from inside, so the walk
+        // steps into every neighbour once and stops there
+        CHECK(sections(culler, world, 0, 0) == 0b1110);
+        CHECK(sections(culler, world, 1, 0) == 0b100);
+        CHECK(sections(culler, world, -1, 0) == 0b100);
+        CHECK(sections(culler, world, 0, 1) == 0b100);
+        CHECK(sections(culler, world, 0, -1) == 0b100);
+        CHECK(sections(culler, world, 2, 0) == 0);
+        CHECK(sections(culler, world, 1, 1) == 0);
+
+        // section waiting for remesh may have been dug open
+        world.chunks[world.chunks.findSlot(1, 0)].data.dirtySections = 0b100;
+        culler.update(world, CAMERA, EVERYWHERE, RADIUS);
+        CHECK(sections(culler, world, 1, 0) == 0b1110);
+        CHECK(sections(culler, world, 2, 0) == 0b100);
+        CHECK(sections(culler, world, 1, 1) == 0b100);
+    }
+
+    void testTunnel() {
+        World world;
+        fillRock(world);
+        // tunnel from chunk -2 to 2 in section 2, turning up into section 3 in chunk 2 and
+        // crossing the section border there before leaving east into chunk 3
+        for (int x = -2; x <= 1; x++) carve(world, x, 0, 2, tunnel);
+        carve(world, 2, 0, 2, tunnelUp);
+        carve(world, 2, 0, 3, tunnelEast);
+        carve(world, 3, 0, 3, tunnel);
+
+        CaveCuller culler;
+        culler.update(world, CAMERA, EVERYWHERE, RADIUS);
+        CHECK(sections(culler, world, 0, 0) == 0b1110);
+        CHECK(sections(culler, world, 1, 0) == 0b100);
+        CHECK(sections(culler, world, -1, 0) == 0b100);
+        CHECK(sections(culler, world, -2, 0) == 0b100);
+        CHECK(sections(culler, world, 2, 0) == 0b1100);
+        CHECK(sections(culler, world, 3, 0) == 0b1000);
+        // rock around the tunnel is never entered
+        CHECK(sections(culler, world, 1, 1) == 0);
+        CHECK(sections(culler, world, 2, 1) == 0);
+
+        // out of radius the walk stops
+        culler.update(world, CAMERA, EVERYWHERE, 1.5f * Chunk::WIDTH);
+        CHECK(sections(culler, world, 1, 0) == 0b100);
+        CHECK(sections(culler, world, 2, 0) == 0);
+
+        // camera outside loaded chunks culls nothing
+        culler.update(world, glm::vec3(1000, 80, 0), EVERYWHERE, RADIUS);
+        CHECK(sections(culler, world, 1, 1) == ChunkData::ALL_SECTIONS);
+    }
+}
+
+int main() {
+    testPairs();
+    testCompute();
+    testSealedRoom();
+    testTunnel();
+    return report();
+}
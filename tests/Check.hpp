@@ -0,0 +1,20 @@
+#pragma once
+
+#include <iostream>
+
+// Minimal checks for test executables. A failed check is reported and the test keeps going,
+// main returns the result of report()
+inline int failures = 0;
+
+#define CHECK(condition)                                                                           \
+    do {                                                                                           \
+        if (!(condition)) {                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            failures++;                                                                            \
+        }                                                                                          \
+    } while (0)
+
+inline int report() {
+    if (failures) std::cerr << failures << " checks failed" << std::endl;
+    return failures ? 1 : 0;
+}
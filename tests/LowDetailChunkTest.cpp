@@ -0,0 +1,86 @@
+#include <random>
+
+#include "Check.hpp"
+#include "game/world/LowDetailChunk.hpp"
+
+// Compares LOD pyramids built with SIMD against a plain per-cell reduction
+namespace {
+    // Most common non-air block of a 2x2x2 group, upper cells first on ties
+    BlockType vote(const BlockType (&children)[8]) {
+        BlockType best = BlockType::AIR;
+        int bestCount = 0;
+        for (const BlockType child : children) {
+            if (child == BlockType::AIR) continue;
+            int count = 0;
+            for (const BlockType other : children) count += other == child;
+            if (count > bestCount) {
+                best = child;
+                bestCount = count;
+            }
+        }
+        return best;
+    }
+
+    LowDetailChunkData reference(const LowDetailChunkData& src) {
+        LowDetailChunkData dst(src.width / 2, src.height / 2, src.depth / 2);
+        for (int y = 0; y < dst.height; y++)
+            for (int z = 0; z < dst.depth; z++)
+                for (int x = 0; x < dst.width; x++) {
+                    const auto at = [&](const int dx, const int dy, const int dz) {
+                        return src.data[src.getID({2 * x + dx, 2 * y + dy, 2 * z + dz})];
+                    };
+                    dst.data[dst.getID({x, y, z})] = vote({
+                        at(0, 1, 0), at(1, 1, 0), at(0, 1, 1), at(1, 1, 1),
+                        at(0, 0, 0), at(1, 0, 0), at(0, 0, 1), at(1, 0, 1)
+                    });
+                }
+        return dst;
+    }
+
+    template <typename Fill>
+    void checkPyramid(Fill&& fill) {
+        Chunk chunk({3, -2});
+        for (size_t i = 0; i < chunk.data.blocks.size(); i++)
+            chunk.data.blocks[i] = fill(ChunkData::getPos(i));
+
+        const std::vector<LowDetailChunk> pyramid = LowDetailChunk::buildPyramid(chunk);
+        CHECK(pyramid.size() == LOD_LEVELS);
+
+        std::vector<LowDetailChunkData> levels;
+        levels.emplace_back(Chunk::WIDTH, Chunk::HEIGHT, Chunk::DEPTH).data = chunk.data.blocks;
+        // widths go down to 2 and 1, below what one SIMD step takes
+        for (const LowDetailChunk& level : pyramid) {
+            levels.push_back(reference(levels.back()));
+            const LowDetailChunkData& expected = levels.back();
+            const LowDetailChunkData& blocks = level.getBlocks();
+            CHECK(level.xCoord == 3 && level.zCoord == -2);
+            CHECK(blocks.width == expected.width && blocks.height == expected.height &&
+                  blocks.depth == expected.depth);
+            CHECK(blocks.data == expected.data);
+        }
+    }
+}
+
+int main() {
+    std::mt19937 random(7);
+    const auto pick = [&](const int types) {
+        return static_cast<BlockType>(std::uniform_int_distribution(0, types - 1)(random));
+    };
+
+    // all five types, every group mixed
+    checkPyramid([&](glm::ivec3) { return pick(5); });
+    // two types only, ties everywhere
+    checkPyramid([&](glm::ivec3) { return pick(2); });
+    // mostly air, groups with a single block
+    checkPyramid([&](glm::ivec3) { return random() % 8 ? BlockType::AIR : pick(5); });
+    // uniform groups only
+    checkPyramid([](glm::ivec3) { return BlockType::AIR; });
+    checkPyramid([](glm::ivec3) { return BlockType::STONE; });
+    // terrain with a grass surface on an odd layer, so it shares groups with air and stone
+    checkPyramid([](const glm::ivec3 pos) {
+        if (pos.y < 99) return BlockType::STONE;
+        return pos.y == 99 ? BlockType::GRASS : BlockType::AIR;
+    });
+
+    return report();
+}
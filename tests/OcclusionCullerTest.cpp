@@ -0,0 +1,83 @@
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Check.hpp"
+#include "render/OcclusionCuller.hpp"
+
+// Rasterizes hand placed occluders in front of a camera at the origin looking down -z
+namespace {
+    constexpr glm::vec3 CAMERA{0.0f};
+
+    glm::mat4 viewProjection() {
+        const glm::mat4 projection = glm::perspective(glm::radians(70.0f), 2.0f, 0.1f, 1000.0f);
+        return projection * glm::lookAt(CAMERA, glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
+    }
+
+    bool allEmpty(const OcclusionCuller& culler) {
+        for (int y = 0; y < OcclusionCuller::HEIGHT; y++)
+            for (int x = 0; x < OcclusionCuller::WIDTH; x++)
+                if (culler.getDepth(x, y) != 0.0f) return false;
+        return true;
+    }
+}
+
+int main() {
+    OcclusionCuller culler;
+
+    // nothing drawn, nothing hidden
+    culler.begin(viewProjection(), CAMERA);
+    culler.finish();
+    CHECK(allEmpty(culler));
+    CHECK(culler.isVisible({{-1, -1, -30}, {1, 1, -28}}));
+
+    // box around the camera crosses the camera plane and is dropped
+    culler.begin(viewProjection(), CAMERA);
+    culler.addOccluder({{-5, -5, -5}, {5, 5, 5}});
+    culler.finish();
+    CHECK(allEmpty(culler));
+
+    // 8x8 wall, its front face 10 blocks away
+    culler.begin(viewProjection(), CAMERA);
+    culler.addOccluder({{-4, -4, -11}, {4, 4, -10}});
+    culler.finish();
+
+    // front face is at w = 10, pixels keep the farthest depth the face has in them
+    const float center = culler.getDepth(OcclusionCuller::WIDTH / 2, OcclusionCuller::HEIGHT / 2);
+    CHECK(center <= 0.1f && center > 0.099f);
+    CHECK(culler.getDepth(0, 0) == 0.0f);
+    // right edge of the wall is at x = 164.56, the pixel it crosses is only partly covered
+    CHECK(culler.getDepth(163, OcclusionCuller::HEIGHT / 2) > 0.0f);
+    CHECK(culler.getDepth(164, OcclusionCuller::HEIGHT / 2) == 0.0f);
+    CHECK(culler.getDepth(OcclusionCuller::WIDTH - 1, OcclusionCuller::HEIGHT - 1) == 0.0f);
+
+    // pyramid keeps the farthest of every 2x2 texels
+    CHECK(culler.getLevelCount() > 1);
+    for (int level = 1; level < culler.getLevelCount(); level++)
+        for (int y = 0; y < OcclusionCuller::HEIGHT >> level; y++)
+            for (int x = 0; x < OcclusionCuller::WIDTH >> level; x++) {
+                const float below = std::min(
+                    std::min(culler.getDepth(2 * x, 2 * y, level - 1), culler.getDepth(2 * x + 1, 2 * y, level - 1)),
+                    std::min(culler.getDepth(2 * x, 2 * y + 1, level - 1),
+                             culler.getDepth(2 * x + 1, 2 * y + 1, level - 1)));
+                CHECK(culler.getDepth(x, y, level) == below);
+            }
+
+    culler.resetStats();
+    // fully hidden behind the wall
+    CHECK(!culler.isVisible({{-1, -1, -30}, {1, 1, -28}}));
+    // reaches past the side of the wall
+    CHECK(culler.isVisible({{2, -1, -30}, {20, 1, -28}}));
+    // thin box behind the wall's right edge, reaching past it by less than a pixel
+    CHECK(culler.isVisible({{11.6f, -0.1f, -29.1f}, {11.7f, 0.1f, -29}}));
+    // in front of the wall
+    CHECK(culler.isVisible({{-1, -1, -6}, {1, 1, -5}}));
+    // touches the wall, not behind it
+    CHECK(culler.isVisible({{-1, -1, -12}, {1, 1, -10}}));
+    // reaches behind the camera, so its screen bounds are unknown
+    CHECK(culler.isVisible({{-1, -1, -30}, {1, 1, 1}}));
+    // completely behind the camera
+    CHECK(culler.isVisible({{-1, -1, 5}, {1, 1, 6}}));
+    CHECK(culler.getStats().tested == 7);
+    CHECK(culler.getStats().culled == 1);
+
+    return report();
+}
@@ -0,0 +1,98 @@
+#include "Check.hpp"
+#include "game/world/World.h"
+
+// Block edits through World, one by one and in batches, and blocks of chunks drawn from their
+// LOD pyramid
+namespace {
+    void testOutsideHeight() {
+        World world;
+        // above and below the world there is nothing to change, no chunk is loaded for it
+        for (const int y : {-1, Chunk::HEIGHT}) {
+            world.changeBlock({5, y, 5}, BlockType::LAMP);
+            BlockEditBatch batch;
+            batch.set({5, y, 5}, BlockType::LAMP);
+            CHECK(batch.empty());
+            world.apply(batch);
+        }
+        CHECK(world.getRevision() == 0);
+        CHECK(world.chunks.findSlot(0, 0) == ChunkMap::NO_SLOT);
+
+        // first and last layer are inside
+        world.changeBlock({5, 0, 5}, BlockType::LAMP);
+        world.changeBlock({5, Chunk::HEIGHT - 1, 5}, BlockType::LAMP);
+        const Chunk* chunk = world.getChunk(0, 0);
+        CHECK(chunk->data.getBlock({5, 0, 5}) == BlockType::LAMP);
+        CHECK(chunk->data.getBlock({5, Chunk::HEIGHT - 1, 5}) == BlockType::LAMP);
+    }
+
+    void testDroppedBlocks() {
+        World world;
+        const LowDetailChunk* built = world.getLowDetailChunk(2, 3, 1);
+        const uint32_t slot = world.chunks.findSlot(2, 3);
+        const std::vector<BlockType> pyramid = built->getBlocks().data;
+        world.dropBlocks(slot);
+        CHECK(!world.chunks[slot].data.hasBlocks());
+
+        // LOD switches reuse the pyramid without generating blocks again
+        for (int LOD = 1; LOD <= LOD_LEVELS; LOD++) world.getLowDetailChunk(2, 3, LOD);
+        CHECK(!world.chunks[slot].data.hasBlocks());
+        CHECK(world.getLowDetailChunk(2, 3, 1)->getBlocks().data == pyramid);
+
+        // an edit needs the blocks back, and keeps them
+        world.changeBlock({2 * Chunk::WIDTH, 200, 3 * Chunk::DEPTH}, BlockType::LAMP);
+        CHECK(world.chunks[slot].data.hasBlocks());
+        world.getLowDetailChunk(2, 3, 1);
+        world.dropBlocks(slot);
+        CHECK(world.chunks[slot].data.hasBlocks());
+    }
+
+    // generates every chunk around the one at 0, 0, with no dirty section
+    void clean(World& world) {
+        for (int x = -1; x <= 1; x++)
+            for (int z = -1; z <= 1; z++) world.chunks[world.getSlot(x, z)].data.clearDirty();
+    }
+
+    uint8_t dirty(const World& world, const int x, const int z) {
+        return world.chunks[world.chunks.findSlot(x, z)].data.dirtySections;
+    }
+
+    void testCornerNeighbours() {
+        // corner column is read by the diagonal chunk's AO, side neighbours see it on their edge
+        for (const bool batched : {false, true}) {
+            World world;
+            clean(world);
+            const glm::ivec3 corner{Chunk::WIDTH - 1, 40, 0};
+            if (batched) {
+                BlockEditBatch batch;
+                batch.set(corner, BlockType::STONE);
+                world.apply(batch);
+            } else {
+                world.changeBlock(corner, BlockType::STONE);
+            }
+            CHECK(dirty(world, 1, -1) == 0b10);
+            CHECK(dirty(world, 1, 0) == 0b10);
+            CHECK(dirty(world, 0, -1) == 0b10);
+            CHECK(dirty(world, -1, 1) == 0);
+            CHECK(dirty(world, 1, 1) == 0);
+            CHECK(dirty(world, -1, -1) == 0);
+        }
+
+        // blocks on two edges but not in a corner dirty no diagonal chunk
+        World world;
+        clean(world);
+        BlockEditBatch batch;
+        batch.set({0, 40, 5}, BlockType::STONE);
+        batch.set({5, 40, 0}, BlockType::STONE);
+        world.apply(batch);
+        CHECK(dirty(world, -1, 0) == 0b10);
+        CHECK(dirty(world, 0, -1) == 0b10);
+        CHECK(dirty(world, -1, -1) == 0);
+    }
+}
+
+int main() {
+    testOutsideHeight();
+    testDroppedBlocks();
+    testCornerNeighbours();
+    return report();
+}